@@ -0,0 +1,68 @@
+#ifndef _CMAES_HH_
+#define _CMAES_HH_
+
+#include <Eigen/Dense>
+
+#include <rl_agent/PolicySearch.hh>
+#include <rl_common/scenario_rng.hh>
+
+/** Covariance matrix adaptation evolution strategy. Each generation samples
+    a population of policies from a normal distribution around the mean
+    policy, and moves the mean and the shape of the distribution towards
+    the policies with the best returns. The population is one wave, so it
+    can be evaluated on all the workers at once.
+
+    When the search has converged (the distribution is tiny, or the best
+    return does not improve), it is restarted from the best policy found
+    with a population twice as large (IPOP-CMA-ES). */
+class Cmaes: public PolicySearch {
+public:
+  /** \param seed Of the samples.
+      \param population Size of the first population. 0 for the default of
+      4 + 3 ln(n_policy).
+      \param model The policies to search. The 8 gains of a LinearPolicy if
+      NULL.
+      \param instance Index of this agent among several that are run at
+      once, see Pegasus. */
+  Cmaes(long seed = 1, int population = 0, Policy* model = NULL,
+        int instance = -1);
+
+  virtual ~Cmaes() {}
+
+  int init_policy();
+
+protected:
+  virtual void next_wave(std::vector<std::vector<float> > &wave);
+  virtual void update(const std::vector<float> &values);
+
+  virtual void save_state(std::ostream &out) const;
+  virtual bool load_state(std::istream &in);
+
+private:
+  long seed;
+  float initial_sigma;
+  int max_restarts, max_stagnation;
+
+  // Strategy parameters, set for a population size by set_population
+  int lambda, mu;
+  Eigen::VectorXd weights;
+  double mueff, cc, cs, c1, cmu, damps, chi_n;
+
+  // State of the distribution
+  Eigen::VectorXd mean, p_sigma, p_c;
+  Eigen::MatrixXd C, B; // C = B diag(D^2) B^T
+  Eigen::VectorXd D;
+  double sigma;
+  long generation; // Since the start, the samples are drawn from it
+  long restart_generation, eigen_generation;
+  int restarts, stagnation;
+
+  std::vector<float> best_policy;
+  float best_value;
+
+  void set_population(int population);
+  void restart();
+  void update_eigen();
+};
+
+#endif
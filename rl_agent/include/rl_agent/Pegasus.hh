@@ -1,42 +1,51 @@
 #ifndef _PEGASUS_HH_
 #define _PEGASUS_HH_
 
-#include <rl_common/core.hh>
+#include <rl_agent/PolicySearch.hh>
+#include <rl_agent/PolicyCache.hh>
 
 
-class Pegasus: public Agent {
+class Pegasus: public PolicySearch {
 public:
   /** Standard constructor
-      \param numinputs The number of possible inputs
-      \param numoutputs The number of possible outputs
+      \param model The policies to search. The 8 gains of a LinearPolicy if
+      NULL.
+      \param environment Configuration of the environment (see
+      HectorQuad::configuration), that the values in policy_cache.bin are
+      of with the Policy::configuration of the model. If "", they are not
+      kept in a file.
+      \param instance Index of this agent among several that are run at
+      once, which keep their policy, checkpoint and cache in files of their
+      own (pegasus_checkpoint_<instance>.txt). -1 for the only one.
   */
-  Pegasus();
+  Pegasus(Policy* model = NULL, const std::string &environment = "",
+          int instance = -1);
 
   virtual ~Pegasus() {}
 
-  virtual std::vector<float> first_action(const std::vector<float> &s);
-  virtual std::vector<float> next_action(float r, const std::vector<float> &s);
-  virtual void last_action(float r);
-
   int init_policy();
-  void update_policy();
-  std::vector<float> get_action(const std::vector<float> &s);
+  using PolicySearch::get_action;
+  const std::vector<float> &get_action(const std::vector<float> &s);
 
 protected:
+  // The current policy and its perturbations by -+policy_change along every
+  // parameter. These are all independent of each other, so the whole
+  // gradient is found from one wave.
+  virtual void next_wave(std::vector<std::vector<float> > &wave);
+  virtual void update(const std::vector<float> &values);
 
 private:
-  int n_policy, n_state, n_action;
   float policy_stepsize, // The stepsize to update to the new policy
-        policy_change, // The epsilon to move to numerically find gradient
-        discount_factor;
-
-  int parameter, max_parameter;
-  std::string policy_file_name;
-  float best_value, value;
-  float left_value, right_value;
-  bool left_done, right_done;
-  std::map<std::vector<float>, float> policy_values;
-  std::vector<float> policy, old_policy, new_policy;
+        policy_change; // The epsilon to move to numerically find gradient
+
+  PolicyCache policy_values;
+
+  // The policies of an update (the current one, then left and right of
+  // every parameter) and their values. Those in the cache are filled in by
+  // next_wave, the others are in the wave at wave_targets.
+  std::vector<std::vector<float> > targets;
+  std::vector<float> target_values;
+  std::vector<int> wave_targets;
 };
 
 #endif
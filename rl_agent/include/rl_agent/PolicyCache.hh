@@ -0,0 +1,83 @@
+#ifndef _POLICYCACHE_HH_
+#define _POLICYCACHE_HH_
+
+#include <stdint.h>
+#include <cstdio>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define POLICY_CACHE_MAGIC 0x524c5043 // "RLPC"
+#define POLICY_CACHE_VERSION 2
+
+/** Returns of the policies evaluated so far, so that policies that are
+    visited again need no rollout.
+
+    Policies are looked up by their parameters rounded to a multiple of
+    `quantum`, in a hash table. At most `capacity` of them are kept in
+    memory, the least recently used ones are dropped first.
+
+    Every insert is also appended to a log file, which is read back (memory
+    mapped) when the cache is created. So a restarted run does not evaluate
+    again what the previous runs did. The returns depend on the environment,
+    so the log has a fingerprint of its configuration, and a log of another
+    configuration is not used. */
+class PolicyCache {
+public:
+  /** \param n_policy Number of parameters of a policy.
+      \param quantum Parameters closer than this are the same policy.
+      \param capacity Maximum number of policies kept in memory.
+      \param file_name The log. "" to not keep one.
+      \param configuration Of the environment the returns are of, the log is
+      only used by caches of the same one. */
+  PolicyCache(int n_policy, double quantum, size_t capacity,
+              const std::string &file_name = "",
+              const std::string &configuration = "");
+  ~PolicyCache();
+
+  /** \return Whether the policy was evaluated, and if so its value. */
+  bool find(const std::vector<float> &policy, float &value);
+  void insert(const std::vector<float> &policy, float value);
+
+  size_t size() const { return index.size(); }
+  long hit_count() const { return hits; }
+  long miss_count() const { return misses; }
+
+private:
+  typedef std::vector<int64_t> Key;
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  // Most recently used first
+  typedef std::list<std::pair<Key, float> > Entries;
+
+  // Start of the log file. It is followed by records of n_policy keys and
+  // the value, all 8 bytes.
+  struct Header {
+    uint32_t magic, version, n_policy, reserved;
+    double quantum;
+    uint64_t fingerprint; // Of the configuration
+  };
+
+  int n_policy;
+  double quantum;
+  uint64_t fingerprint;
+  size_t capacity;
+  std::string file_name;
+  FILE* log;
+  long hits, misses;
+
+  Entries entries;
+  std::unordered_map<Key, Entries::iterator, KeyHash> index;
+
+  Key quantize(const std::vector<float> &policy) const;
+  void put(const Key &key, float value);
+
+  // Reads the log into the cache and opens it for appending
+  void open_log();
+};
+
+#endif
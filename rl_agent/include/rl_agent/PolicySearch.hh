@@ -0,0 +1,113 @@
+#ifndef _POLICYSEARCH_HH_
+#define _POLICYSEARCH_HH_
+
+#include <rl_common/core.hh>
+#include <rl_agent/policy/Policy.h>
+
+/** Base of the agents that improve a policy from the returns of whole
+    episodes. Each update needs the returns of a "wave" of policies (eg. the
+    perturbations of a finite difference gradient) which can be evaluated in
+    any order, and in parallel.
+
+    Used as an Agent, the episodes evaluate the policies of the wave one
+    after the other. A rollout pool (see rl_runner --parallel) instead takes
+    the policies of the wave with wave_policy(), runs them on several
+    environments with get_action(), and gives back the returns with
+    report().
+
+    The policies are weight vectors of a Policy, eg. the gains of a
+    LinearPolicy or the weights of a NeuralNetwork. */
+class PolicySearch: public Agent {
+public:
+  /** \param model The family of the policies. Its weights are the
+      initial policy. It is owned (and deleted) by the agent.
+      \param discount_factor Of the rewards, in the return of an episode. */
+  PolicySearch(Policy* model, float discount_factor);
+
+  virtual ~PolicySearch();
+
+  virtual const std::vector<float> &first_action(const std::vector<float> &s);
+  virtual const std::vector<float> &next_action(float r, const std::vector<float> &s);
+  virtual void last_action(float r);
+
+  /** The action of a policy, which need not be the current one, written
+      into `action` (action_size() floats) without allocating. */
+  void get_action(const std::vector<float> &p, const float* s,
+                  float* action) const {
+    model->get_action(&p[0], s, action);
+  }
+  /** The same, into the scratch vector of the agent, which is returned.
+      It is valid until the next call. */
+  const std::vector<float> &get_action(const std::vector<float> &p,
+                                       const std::vector<float> &s);
+
+  int state_size() const { return n_state; }
+  int action_size() const { return n_action; }
+
+  int wave_size() const { return wave.size(); }
+  const std::vector<float> &wave_policy(int i) const { return wave[i]; }
+  float discount() const { return discount_factor; }
+
+  /** Gives the return of an episode of wave_policy(i). When all the wave
+      has been reported, the policy is updated and the next wave starts.
+      \return Whether this started a new wave. */
+  bool report(int i, float value);
+
+protected:
+  int n_policy, n_state, n_action;
+  float discount_factor;
+  Policy* model;
+  std::vector<float> policy; // The policy being improved
+  std::vector<float> action; // Scratch vector for the Agent interface
+
+  /** base, eg. "policy.txt", with "_<instance>" before its extension: the
+      file of one of several agents run at once. base itself for -1. */
+  static std::string instance_file_name(const std::string &base, int instance);
+
+  // Where the policy is read from at the start and saved to, "" for none
+  std::string policy_file_name;
+  void load_policy();
+  void save_policy(const std::vector<float> &p) const;
+
+  // Policies to evaluate before the next update, and their returns
+  std::vector<std::vector<float> > wave;
+  std::vector<float> wave_values;
+  std::vector<bool> wave_reported;
+  int n_reported;
+
+  // Sequential evaluation through the Agent interface
+  int current;
+  float value;
+
+  // The policy and the returns reported for the current wave are saved
+  // here after every report, so a run that is killed loses at most the
+  // episodes that were being run. "" to not save them.
+  std::string checkpoint_file_name;
+  std::vector<std::pair<std::vector<float>, float> > resumed;
+
+  /** Sets the policies whose returns are needed for the next update. The
+      wave may be left empty, eg. if all of them were evaluated before. */
+  virtual void next_wave(std::vector<std::vector<float> > &wave) = 0;
+
+  /** Updates the policy from the returns of the wave. */
+  virtual void update(const std::vector<float> &values) = 0;
+
+  /** Starts the next non-empty wave. To be called by the derived class
+      once its policy is initialized. Returns resumed from a checkpoint are
+      given to the policies of the wave they were reported for. */
+  void start_wave();
+
+  /** Reads the checkpoint, if there is one: sets the policy, and keeps the
+      returns to give them to the next wave.
+      \return Whether the state was resumed. */
+  bool resume();
+  void save_checkpoint() const;
+
+  /** Extra state of the search in the checkpoint, after the returns. The
+      state read must only be used if all of it could be read.
+      \return Whether it could be read. */
+  virtual void save_state(std::ostream &out) const {}
+  virtual bool load_state(std::istream &in) { return true; }
+};
+
+#endif
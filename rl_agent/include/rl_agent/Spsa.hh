@@ -0,0 +1,41 @@
+#ifndef _SPSA_HH_
+#define _SPSA_HH_
+
+#include <rl_agent/PolicySearch.hh>
+#include <rl_common/scenario_rng.hh>
+
+/** Simultaneous perturbation gradient ascent. Instead of moving one
+    parameter at a time like Pegasus, every evaluation perturbs all the
+    parameters at once, by +-policy_change along a random direction of +-1
+    entries. An update evaluates `directions` such antithetic pairs as one
+    wave, so it costs 2 * directions rollouts whatever the number of
+    parameters. */
+class Spsa: public PolicySearch {
+public:
+  /** \param seed Of the random directions.
+      \param directions Number of antithetic pairs per update.
+      \param model The policies to search. The 8 gains of a LinearPolicy if
+      NULL.
+      \param instance Index of this agent among several that are run at
+      once, see Pegasus. */
+  Spsa(long seed = 1, int directions = 4, Policy* model = NULL,
+       int instance = -1);
+
+  virtual ~Spsa() {}
+
+  int init_policy();
+
+protected:
+  virtual void next_wave(std::vector<std::vector<float> > &wave);
+  virtual void update(const std::vector<float> &values);
+
+private:
+  int n_directions;
+  float policy_stepsize, // The stepsize to update to the new policy
+        policy_change; // The size of the perturbations
+  long seed;
+
+  std::vector<std::vector<float> > deltas; // Directions of the current wave
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef _FIXEDNETWORK_H_
+#define _FIXEDNETWORK_H_
+
+#include <array>
+#include <cassert>
+#include <vector>
+#include <rl_agent/policy/NeuralNetwork.h>
+
+namespace fixed_network {
+
+// y = activation(W x + b) for a row-major Out x (In + 1) block of weights
+// whose last column is the bias, as in the layers of NeuralNetwork. With
+// the sizes known Eigen unrolls the product and vectorizes the activation.
+template <int In, int Out>
+inline void dense(const float* w, const float* x, float* y, Activation activation) {
+    typedef Eigen::Matrix<float, Out, In + 1, Eigen::RowMajor> Weights;
+    Eigen::Map<const Weights> layer(w);
+    Eigen::Map<const Eigen::Matrix<float, In, 1> > in(x);
+    Eigen::Map<Eigen::Matrix<float, Out, 1> > out(y);
+    out.noalias() = layer.template leftCols<In>() * in;
+    out += layer.col(In);
+
+    switch(activation) {
+    case SIGMOID:
+        out.array() = (1.0f + (-out.array()).exp()).inverse();
+        break;
+    case FAST_SIGMOID:
+        out.array() = 0.5f * (0.5f * out.array()).tanh() + 0.5f;
+        break;
+    case TANH:
+        out.array() = out.array().tanh();
+        break;
+    case RELU:
+        out = out.cwiseMax(0.0f);
+        break;
+    case LINEAR:
+        break;
+    }
+}
+
+// The layers from In to the last size. The outputs of the hidden layers
+// live on the stack of forward().
+template <int In, int Out, int... Rest>
+struct Layers {
+    typedef Layers<Out, Rest...> Next;
+    static constexpr int n_weights = Out * (In + 1) + Next::n_weights;
+    static constexpr int n_outputs = Next::n_outputs;
+
+    static void forward(const float* w, const float* x, float* y,
+                        Activation hidden, Activation output) {
+        std::array<float, Out> h;
+        dense<In, Out>(w, x, h.data(), hidden);
+        Next::forward(w + Out * (In + 1), h.data(), y, hidden, output);
+    }
+};
+
+template <int In, int Out>
+struct Layers<In, Out> {
+    static constexpr int n_weights = Out * (In + 1);
+    static constexpr int n_outputs = Out;
+
+    static void forward(const float* w, const float* x, float* y,
+                        Activation, Activation output) {
+        dense<In, Out>(w, x, y, output);
+    }
+};
+
+}
+
+/** NeuralNetwork with its shape fixed at compile time, for the controllers
+    that are deployed rather than searched: FixedNetwork<8, 16, 16, 4> has 8
+    inputs, two hidden layers of 16 and 4 outputs. The weights are in a
+    std::array in the same flat layout as NeuralNetwork's, so the weights a
+    NeuralNetwork of this shape was trained to can be loaded as they are.
+    All the sizes are constants, so the products are unrolled and vectorized
+    for the shape, and a forward pass neither allocates nor branches on
+    sizes. */
+template <int... Sizes>
+class FixedNetwork {
+public:
+    typedef fixed_network::Layers<Sizes...> Layers;
+    static constexpr int n_weights = Layers::n_weights;
+    static constexpr int n_outputs = Layers::n_outputs;
+
+    FixedNetwork(Activation hidden=SIGMOID, Activation output=SIGMOID)
+        : hidden(hidden), output(output) {
+        weights.fill(0);
+    }
+
+    /** \param w The weights of a NeuralNetwork of the same shape, eg. from
+        its get_weights() or a policy.txt it saved. */
+    void set_weights(const std::vector<float> &w) {
+        assert(w.size() == n_weights);
+        set_weights(&w[0]);
+    }
+
+    void set_weights(const float* w) {
+        for(int i=0; i<n_weights; ++i) {
+            weights[i] = w[i];
+        }
+    }
+
+    const std::array<float, Layers::n_weights>& get_weights() const { return weights; }
+
+    /** \param input The inputs, as many as the first size.
+        \param out Set to the outputs, as many as the last size. */
+    void forward(const float* input, float* out) const {
+        Layers::forward(weights.data(), input, out, hidden, output);
+    }
+
+private:
+    Activation hidden, output;
+    std::array<float, Layers::n_weights> weights;
+};
+
+template <int... Sizes>
+constexpr int FixedNetwork<Sizes...>::n_weights;
+template <int... Sizes>
+constexpr int FixedNetwork<Sizes...>::n_outputs;
+
+#endif
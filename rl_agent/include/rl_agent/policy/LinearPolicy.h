@@ -0,0 +1,28 @@
+#ifndef _LINEARPOLICY_H_
+#define _LINEARPOLICY_H_
+
+#include <rl_agent/policy/Policy.h>
+
+/** The controller Pegasus was written for: the state holds an (error, rate)
+    pair per action, eg. (target z - z, vz) for the z velocity command, and
+    each action is a weighted sum of its pair. The initial weights are 0. */
+class LinearPolicy: public Policy {
+public:
+    LinearPolicy(int n_state = 8, int n_action = 4);
+
+    virtual int get_n_weights() const { return weights.size(); }
+    virtual int input_size() const { return n_state; }
+    virtual int output_size() const { return n_action; }
+
+    virtual void get_weights(std::vector<float> &w) const { w = weights; }
+    virtual void set_weights(const std::vector<float> &w);
+    virtual void get_value(const std::vector<float> &input, std::vector<float> &output);
+    virtual void get_action(const float* weights, const float* state, float* action);
+    virtual std::string configuration() const;
+
+private:
+    int n_state, n_action;
+    std::vector<float> weights;
+};
+
+#endif
@@ -1,43 +1,91 @@
-#include <iostream>
+#ifndef _NEURALNETWORK_H_
+#define _NEURALNETWORK_H_
+
 #include <vector>
-#include <math.h>
-#include <stdlib.h> 
-#include <time.h>
-#include <rl_agent/policy/utils.cpp>
+#include <Eigen/Dense>
 #include <rl_common/core.hh>
+#include <rl_common/scenario_rng.hh>
+#include <rl_agent/policy/Policy.h>
 
-class Neuron {
-public:
-    int n_inputs;
-    std::vector<float> weights;
-
-    Neuron(int n);
-    float random_weight(float min_w=-0.1, float max_w=0.1);
-    float get_output(std::vector<float> inp); 
-    float activate(float inp);
+enum Activation {
+    LINEAR,
+    SIGMOID,
+    FAST_SIGMOID, // 0.5 tanh(x / 2) + 0.5, with Eigen's vectorized tanh
+    TANH,
+    RELU
 };
 
-class NeuralLayer {
+/** Fully connected network. All the weights are in one flat vector, which
+    optimizers can read and write directly (see parameters()). Each layer
+    is a block of it, a row-major n_out x (n_in + 1) matrix whose last
+    column is the bias, ie. the weights of a neuron followed by its bias.
+
+    The forward pass is a matrix-vector product per layer into buffers
+    allocated once, so it does not allocate. Batches of states are a
+    (blocked) matrix-matrix product per layer instead; their buffers only
+    grow when a larger batch than before is given. */
+class NeuralNetwork: public Policy {
 public:
-    int n_neurons;
-    std::vector<Neuron> neurons;
+    typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> LayerMatrix;
 
-    NeuralLayer(int n, int inp); 
-    std::vector<float> get_outputs(std::vector<float> inp);
-};
+    // The initial weights are the same for the same seed
+    NeuralNetwork(int n_i=0, int n_o=0, int n_h=0, int n_per_h=0, long seed=1,
+                  Activation hidden=SIGMOID, Activation output=SIGMOID);
+
+    virtual int get_n_weights() const { return weights.size(); }
+    virtual void get_weights(std::vector<float> &weights) const;
+    virtual void set_weights(const std::vector<float> &w);
+    virtual void get_value(const std::vector<float> &input, std::vector<float> &output);
+
+    /** Output for the weights given in the layout of parameters(), written
+        into action. Does not allocate after the first call. */
+    virtual void get_action(const float* weights, const float* state, float* action);
+    virtual std::string configuration() const;
+
+    /** \param input n_inputs floats.
+        \return The n_outputs outputs, valid until the next call. */
+    const float* forward(const float* input);
+
+    /** Evaluates a batch of states.
+        \param inputs Row-major batch x n_inputs array.
+        \param outputs Row-major batch x n_outputs array. */
+    void forward_batch(const float* inputs, int batch, float* outputs);
+
+    /** Evaluates a population of networks of this shape, whose weights are
+        stored one after the other in `arena` (population x get_n_weights(),
+        in the layout of parameters()).
+        \param inputs Member p evaluates the `batch` states (row-major) at
+        inputs + p * input_stride. With a stride of 0 all the members get
+        the same states.
+        \param outputs Row-major population x batch x n_outputs array. */
+    void forward_population(const float* arena, int population,
+                            const float* inputs, int batch, int input_stride,
+                            float* outputs);
+
+    float* parameters() { return &weights[0]; }
+    virtual int input_size() const { return n_inputs; }
+    virtual int output_size() const { return n_outputs; }
+
+    static void activate(Eigen::Ref<Eigen::VectorXf> x, Activation activation);
+
+private:
+    struct Layer {
+        int n_in, n_out;
+        int offset; // Of its block in weights
+        Activation activation;
+    };
 
-class NeuralNetwork {
     int n_inputs;
     int n_hidden_layers;
     int n_outputs;
     int n_per_hidden_layer;
-    std::vector<NeuralLayer> layers;
+    std::vector<Layer> layers;
     std::vector<float> weights;
+    std::vector<Eigen::VectorXf> outputs; // Of each layer
+    std::vector<std::vector<float> > batch_outputs; // Of each layer, row-major
+    int batch_capacity;
 
-public:    
-    NeuralNetwork(int n_i=0, int n_o=0, int n_h=0, int n_per_h=0);
-     int get_n_weights();
-     void get_weights(std::vector<float> &weights);
-     void set_weights(std::vector<float> w);
-     void get_value(std::vector<float> &input, std::vector<float> &output);
+    void run_batch(const float* w, const float* inputs, int batch, float* outputs);
 };
+
+#endif
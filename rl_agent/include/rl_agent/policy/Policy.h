@@ -1,10 +1,42 @@
+#ifndef _POLICY_H_
+#define _POLICY_H_
+
+#include <string>
 #include <vector>
 
+/** A family of controllers, state -> action, with a vector of weights.
+    The agents search over the weights; get_action evaluates any weight
+    vector of the family without copying it in, and writes the action into
+    a buffer of the caller, so it does not allocate. */
 class Policy {
-public:    
-    virtual int get_n_weights();
-    virtual void get_weights(std::vector<float> &weights);
-    virtual void set_weights(std::vector<float> w);
-    virtual void get_value(std::vector<float> &input, std::vector<float> &output);
-    virtual ~Policy();
+public:
+    virtual int get_n_weights() const = 0;
+    virtual int input_size() const = 0;
+    virtual int output_size() const = 0;
+
+    // The weights of the policy itself, eg. the initial ones
+    virtual void get_weights(std::vector<float> &weights) const = 0;
+    virtual void set_weights(const std::vector<float> &w) = 0;
+    virtual void get_value(const std::vector<float> &input, std::vector<float> &output) = 0;
+
+    /** \param weights get_n_weights() floats.
+        \param state input_size() floats.
+        \param action Set to the output_size() floats of the action. */
+    virtual void get_action(const float* weights, const float* state, float* action) = 0;
+
+    /** The family and shape of the policy, eg. "neural 8-8-4 tanh linear".
+        Two policies of the same configuration give the same action for the
+        same weights. */
+    virtual std::string configuration() const = 0;
+
+    virtual ~Policy() {}
+
+    /** \param type "linear" or "neural".
+        \param hidden Units of the hidden layer of "neural", 0 for none.
+        \param seed Of the initial weights of "neural".
+        \return NULL for an unknown type. */
+    static Policy* create(const std::string &type, int n_state, int n_action,
+                          int hidden = 8, long seed = 1);
 };
+
+#endif
@@ -0,0 +1,258 @@
+#include <rl_agent/Cmaes.hh>
+#include <rl_agent/policy/LinearPolicy.h>
+
+#include <cmath>
+#include <iomanip>
+
+Cmaes::Cmaes(long sd, int population, Policy* model, int instance)
+  : PolicySearch(model != NULL ? model : new LinearPolicy(8, 4), 0.90) {
+  seed = sd;
+  policy_file_name = instance_file_name("policy.txt", instance);
+  checkpoint_file_name = instance_file_name("cmaes_checkpoint.txt", instance);
+
+  initial_sigma = 0.05;
+  max_restarts = 9;
+  max_stagnation = 50; // Generations without a better return
+
+  int n = n_policy;
+  if (population <= 0) {
+    population = 4 + (int)(3 * log((double)n));
+  }
+  set_population(population);
+  chi_n = sqrt((double)n) * (1 - 1.0 / (4 * n) + 1.0 / (21.0 * n * n));
+
+  generation = 0;
+  restarts = 0;
+  best_value = -FLT_MAX;
+
+  init_policy();
+  start_wave();
+}
+
+int Cmaes::init_policy() {
+  load_policy();
+  best_policy = policy;
+  restart();
+
+  std::cout << "Initialized policy = " << policy << "\n";
+  resume();
+  return n_policy;
+}
+
+// --------------- STRATEGY ----------------------------
+
+// Default parameters of Hansen's "The CMA Evolution Strategy: A Tutorial"
+void Cmaes::set_population(int population) {
+  int n = n_policy;
+  lambda = std::max(population, 2);
+  mu = lambda / 2;
+
+  weights.resize(mu);
+  for (int i = 0; i < mu; ++i) {
+    weights[i] = log(mu + 0.5) - log(i + 1.0);
+  }
+  weights /= weights.sum();
+  mueff = 1 / weights.squaredNorm();
+
+  cc = (4 + mueff / n) / (n + 4 + 2 * mueff / n);
+  cs = (mueff + 2) / (n + mueff + 5);
+  c1 = 2 / ((n + 1.3) * (n + 1.3) + mueff);
+  cmu = std::min(1 - c1,
+                 2 * (mueff - 2 + 1 / mueff) / ((n + 2) * (n + 2) + mueff));
+  damps = 1 + 2 * std::max(0.0, sqrt((mueff - 1) / (n + 1)) - 1) + cs;
+}
+
+// Starts the distribution again around the policy
+void Cmaes::restart() {
+  int n = n_policy;
+  mean.resize(n);
+  for (int i = 0; i < n; ++i) {
+    mean[i] = policy[i];
+  }
+  p_sigma = Eigen::VectorXd::Zero(n);
+  p_c = Eigen::VectorXd::Zero(n);
+  C = Eigen::MatrixXd::Identity(n, n);
+  B = Eigen::MatrixXd::Identity(n, n);
+  D = Eigen::VectorXd::Ones(n);
+  sigma = initial_sigma;
+  restart_generation = 0;
+  eigen_generation = 0;
+  stagnation = 0;
+}
+
+void Cmaes::update_eigen() {
+  // Enforce symmetry, then C = B diag(D^2) B^T
+  C = C.triangularView<Eigen::Upper>();
+  C.triangularView<Eigen::StrictlyLower>() = C.transpose();
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen(C);
+  B = eigen.eigenvectors();
+  D = eigen.eigenvalues().cwiseMax(1e-20).cwiseSqrt();
+  eigen_generation = generation;
+}
+
+void Cmaes::next_wave(std::vector<std::vector<float> > &wave) {
+  // The samples only depend on the seed and the generation, so a resumed
+  // run evaluates the same population again.
+  ScenarioRng rng(seed, generation, ScenarioRng::PERTURBATIONS);
+  Eigen::VectorXd z(n_policy);
+  std::vector<float> sample(n_policy);
+  for (int k = 0; k < lambda; ++k) {
+    for (int i = 0; i < n_policy; ++i) {
+      z[i] = rng.normal();
+    }
+    Eigen::VectorXd x = mean + sigma * (B * D.cwiseProduct(z));
+    for (int i = 0; i < n_policy; ++i) {
+      sample[i] = x[i];
+    }
+    wave.push_back(sample);
+  }
+}
+
+void Cmaes::update(const std::vector<float> &values) {
+  int n = n_policy;
+
+  // Best returns first
+  std::vector<std::pair<float, int> > ranking(lambda);
+  for (int k = 0; k < lambda; ++k) {
+    ranking[k] = std::make_pair(-values[k], k);
+  }
+  std::sort(ranking.begin(), ranking.end());
+
+  float generation_best = -ranking[0].first;
+  if (generation_best > best_value) {
+    best_value = generation_best;
+    best_policy = wave[ranking[0].second];
+    stagnation = 0;
+  } else {
+    stagnation++;
+  }
+
+  // Steps of the selected samples, in units of sigma
+  Eigen::MatrixXd Y(n, mu);
+  for (int j = 0; j < mu; ++j) {
+    const std::vector<float> &x = wave[ranking[j].second];
+    for (int i = 0; i < n; ++i) {
+      Y(i, j) = (x[i] - mean[i]) / sigma;
+    }
+  }
+  Eigen::VectorXd y_w = Y * weights;
+  mean += sigma * y_w;
+
+  // Evolution paths. C^-1/2 = B diag(1/D) B^T
+  Eigen::VectorXd c_invsqrt_y = B * (B.transpose() * y_w).cwiseQuotient(D);
+  p_sigma = (1 - cs) * p_sigma + sqrt(cs * (2 - cs) * mueff) * c_invsqrt_y;
+  restart_generation++;
+  double hsig_norm = p_sigma.norm() /
+    sqrt(1 - pow(1 - cs, 2.0 * restart_generation)) / chi_n;
+  bool hsig = hsig_norm < 1.4 + 2.0 / (n + 1);
+  p_c = (1 - cc) * p_c;
+  if (hsig) {
+    p_c += sqrt(cc * (2 - cc) * mueff) * y_w;
+  }
+
+  // Covariance: rank one and rank mu updates
+  double c1a = c1 * (1 - (hsig ? 0 : cc * (2 - cc)));
+  C = (1 - c1a - cmu) * C + c1 * p_c * p_c.transpose() +
+      cmu * Y * weights.asDiagonal() * Y.transpose();
+  sigma *= exp((cs / damps) * (p_sigma.norm() / chi_n - 1));
+  generation++;
+
+  // The decomposition is O(n^3), it is only redone as often as C changes
+  // noticeably.
+  if (generation - eigen_generation > lambda / (c1 + cmu) / n / 10) {
+    update_eigen();
+  }
+
+  for (int i = 0; i < n; ++i) {
+    policy[i] = mean[i];
+  }
+  std::cout << "Generation " << generation << ": best value "
+            << generation_best << " (overall " << best_value << ")"
+            << ", sigma " << sigma << "\n"
+            << "Mean policy " << policy << "\n";
+
+  save_policy(best_policy);
+
+  double condition = D.maxCoeff() / D.minCoeff();
+  if (sigma * D.maxCoeff() < 1e-6 || condition > 1e7 ||
+      stagnation >= max_stagnation) {
+    if (restarts >= max_restarts) {
+      std::cout << "##### FINISHED (converged) #####\n";
+      exit(0);
+    }
+    restarts++;
+    set_population(2 * lambda);
+    policy = best_policy;
+    restart();
+    std::cout << "Restart " << restarts << " from the best policy, population "
+              << lambda << "\n";
+  }
+}
+
+// --------------- CHECKPOINT ----------------------------
+
+static void write(std::ostream &out, const Eigen::MatrixXd &m) {
+  for (int i = 0; i < m.size(); ++i) {
+    out << m.data()[i] << " ";
+  }
+  out << "\n";
+}
+
+static bool read(std::istream &in, Eigen::MatrixXd &m) {
+  for (int i = 0; i < m.size(); ++i) {
+    in >> m.data()[i];
+  }
+  return !in.fail();
+}
+
+void Cmaes::save_state(std::ostream &out) const {
+  out << std::setprecision(17);
+  out << lambda << " " << generation << " " << restart_generation << " "
+      << eigen_generation << " " << restarts << " " << stagnation << " "
+      << sigma << " " << best_value << "\n";
+  std::ostream_iterator<float> output_iterator(out, " ");
+  std::copy(best_policy.begin(), best_policy.end(), output_iterator);
+  out << "\n";
+  write(out, mean);
+  write(out, p_sigma);
+  write(out, p_c);
+  write(out, C);
+  write(out, B);
+  write(out, D);
+}
+
+bool Cmaes::load_state(std::istream &in) {
+  int n = n_policy;
+  int l, r, st;
+  long g, rg, eg;
+  double s;
+  float bv;
+  std::vector<float> bp(n);
+  Eigen::MatrixXd m(n, 1), ps(n, 1), pc(n, 1), c(n, n), b(n, n), d(n, 1);
+
+  in >> l >> g >> rg >> eg >> r >> st >> s >> bv;
+  for (int i = 0; i < n; ++i) {
+    in >> bp[i];
+  }
+  if ( in.fail() || !read(in, m) || !read(in, ps) || !read(in, pc) ||
+       !read(in, c) || !read(in, b) || !read(in, d) ) {
+    return false;
+  }
+
+  set_population(l);
+  generation = g;
+  restart_generation = rg;
+  eigen_generation = eg;
+  restarts = r;
+  stagnation = st;
+  sigma = s;
+  best_value = bv;
+  best_policy = bp;
+  mean = m;
+  p_sigma = ps;
+  p_c = pc;
+  C = c;
+  B = b;
+  D = d;
+  return true;
+}
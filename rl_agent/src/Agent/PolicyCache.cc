@@ -0,0 +1,190 @@
+#include <rl_agent/PolicyCache.hh>
+
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// FNV-1a
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+namespace {
+
+uint64_t hash_bytes(const char* data, size_t size) {
+  uint64_t h = FNV_OFFSET;
+  for (size_t i = 0; i < size; ++i) {
+    h = (h ^ static_cast<uint8_t>(data[i])) * FNV_PRIME;
+  }
+  return h;
+}
+
+} // namespace
+
+PolicyCache::PolicyCache(int np, double q, size_t c, const std::string &f,
+                         const std::string &configuration) {
+  n_policy = np;
+  quantum = q;
+  fingerprint = hash_bytes(configuration.data(), configuration.size());
+  capacity = std::max<size_t>(c, 1);
+  file_name = f;
+  log = NULL;
+  hits = 0;
+  misses = 0;
+  index.reserve(capacity);
+
+  if (file_name != "") {
+    open_log();
+  }
+}
+
+PolicyCache::~PolicyCache() {
+  if (log != NULL) {
+    fclose(log);
+  }
+}
+
+size_t PolicyCache::KeyHash::operator()(const Key &key) const {
+  // Over the quantized parameters
+  uint64_t h = FNV_OFFSET;
+  for (size_t i = 0; i < key.size(); ++i) {
+    h = (h ^ static_cast<uint64_t>(key[i])) * FNV_PRIME;
+  }
+  return h;
+}
+
+PolicyCache::Key PolicyCache::quantize(const std::vector<float> &policy) const {
+  assert((int)policy.size() == n_policy);
+  Key key(n_policy);
+  for (int i = 0; i < n_policy; ++i) {
+    key[i] = llround(policy[i] / quantum);
+  }
+  return key;
+}
+
+bool PolicyCache::find(const std::vector<float> &policy, float &value) {
+  std::unordered_map<Key, Entries::iterator, KeyHash>::iterator it =
+    index.find(quantize(policy));
+  if (it == index.end()) {
+    misses++;
+    return false;
+  }
+  hits++;
+  // Now the most recently used
+  entries.splice(entries.begin(), entries, it->second);
+  value = it->second->second;
+  return true;
+}
+
+void PolicyCache::insert(const std::vector<float> &policy, float value) {
+  Key key = quantize(policy);
+  put(key, value);
+
+  if (log != NULL) {
+    std::vector<int64_t> record(key.begin(), key.end());
+    double v = value;
+    record.push_back(0);
+    memcpy(&record.back(), &v, sizeof(v));
+    fwrite(&record[0], sizeof(int64_t), record.size(), log);
+    fflush(log); // Keep what was evaluated even if the run is killed
+  }
+}
+
+void PolicyCache::put(const Key &key, float value) {
+  std::unordered_map<Key, Entries::iterator, KeyHash>::iterator it =
+    index.find(key);
+  if (it != index.end()) {
+    it->second->second = value;
+    entries.splice(entries.begin(), entries, it->second);
+    return;
+  }
+
+  if (index.size() >= capacity) {
+    index.erase(entries.back().first);
+    entries.pop_back();
+  }
+  entries.push_front(std::make_pair(key, value));
+  index[key] = entries.begin();
+}
+
+void PolicyCache::open_log() {
+  size_t record_size = (n_policy + 1) * sizeof(int64_t);
+  off_t valid_size = 0;
+
+  int fd = open(file_name.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(Header)) {
+    void* mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mem == MAP_FAILED) {
+      std::cerr << "PolicyCache: cannot map " << file_name << ": "
+                << strerror(errno) << "\n";
+      close(fd);
+      return;
+    }
+
+    const Header* header = static_cast<const Header*>(mem);
+    if (header->magic != POLICY_CACHE_MAGIC ||
+        header->version != POLICY_CACHE_VERSION ||
+        header->n_policy != (uint32_t)n_policy || header->quantum != quantum) {
+      std::cerr << "PolicyCache: " << file_name << " is not a cache of this "
+                << "policy, it is neither used nor written\n";
+      munmap(mem, st.st_size);
+      close(fd);
+      return;
+    }
+    if (header->fingerprint != fingerprint) {
+      std::cerr << "PolicyCache: " << file_name << " has the returns of "
+                << "another configuration, seed or policy family, it is "
+                << "neither used nor written. Remove it to start a new one\n";
+      munmap(mem, st.st_size);
+      close(fd);
+      return;
+    }
+
+    // Replayed in order, so the last records are the most recently used.
+    // A record cut short by a killed run is dropped.
+    size_t records = (st.st_size - sizeof(Header)) / record_size;
+    const char* data = static_cast<const char*>(mem) + sizeof(Header);
+    Key key(n_policy);
+    for (size_t r = 0; r < records; ++r) {
+      const char* record = data + r * record_size;
+      memcpy(&key[0], record, n_policy * sizeof(int64_t));
+      double v;
+      memcpy(&v, record + n_policy * sizeof(int64_t), sizeof(v));
+      put(key, v);
+    }
+    valid_size = sizeof(Header) + records * record_size;
+    munmap(mem, st.st_size);
+
+    std::cout << "PolicyCache: Loaded " << records << " evaluations from "
+              << file_name << "\n";
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+
+  if (valid_size > 0 && truncate(file_name.c_str(), valid_size) != 0) {
+    std::cerr << "PolicyCache: cannot truncate " << file_name << ": "
+              << strerror(errno) << "\n";
+    return;
+  }
+
+  log = fopen(file_name.c_str(), valid_size > 0 ? "ab" : "wb");
+  if (log == NULL) {
+    std::cerr << "PolicyCache: cannot write " << file_name << ": "
+              << strerror(errno) << "\n";
+    return;
+  }
+  if (valid_size == 0) {
+    Header header = {POLICY_CACHE_MAGIC, POLICY_CACHE_VERSION,
+                     (uint32_t)n_policy, 0, quantum, fingerprint};
+    fwrite(&header, sizeof(header), 1, log);
+    fflush(log);
+  }
+}
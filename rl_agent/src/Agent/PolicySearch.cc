@@ -0,0 +1,223 @@
+#include <rl_agent/PolicySearch.hh>
+
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+
+#define CHECKPOINT_HEADER "policy_search_checkpoint"
+
+PolicySearch::PolicySearch(Policy* m, float discount) {
+  model = m;
+  n_policy = model->get_n_weights();
+  n_state = model->input_size();
+  n_action = model->output_size();
+  discount_factor = discount;
+  model->get_weights(policy);
+  action.resize(n_action);
+  policy_file_name = "";
+  n_reported = 0;
+  current = 0;
+  value = 0;
+  checkpoint_file_name = "";
+}
+
+PolicySearch::~PolicySearch() {
+  delete model;
+}
+
+std::string PolicySearch::instance_file_name(const std::string &base,
+                                             int instance) {
+  if (instance < 0) {
+    return base;
+  }
+  std::stringstream suffix;
+  suffix << "_" << instance;
+  size_t dot = base.rfind('.');
+  if (dot == std::string::npos) {
+    return base + suffix.str();
+  }
+  return base.substr(0, dot) + suffix.str() + base.substr(dot);
+}
+
+const std::vector<float> &PolicySearch::get_action(const std::vector<float> &p,
+                                                   const std::vector<float> &s) {
+  assert((int)s.size() == n_state);
+  get_action(p, &s[0], &action[0]);
+  return action;
+}
+
+const std::vector<float> &PolicySearch::first_action(const std::vector<float> &s) {
+  // Evaluate the first policy of the wave that has no return yet
+  current = 0;
+  while (current < wave_size() && wave_reported[current]) {
+    current++;
+  }
+  assert(current < wave_size());
+  value = 0;
+  return get_action(wave[current], s);
+}
+
+const std::vector<float> &PolicySearch::next_action(float r,
+                                                    const std::vector<float> &s) {
+  // To us, only the final reward matters from the episode for finding the best policy
+  value = discount_factor * value + r;
+  return get_action(wave[current], s);
+}
+
+void PolicySearch::last_action(float r) {
+  value = discount_factor * value + r;
+  report(current, value);
+  value = 0;
+}
+
+bool PolicySearch::report(int i, float v) {
+  assert(i >= 0 && i < wave_size());
+  if (wave_reported[i]) {
+    return false;
+  }
+  wave_values[i] = v;
+  wave_reported[i] = true;
+  n_reported++;
+
+  if (n_reported < wave_size()) {
+    save_checkpoint();
+    return false;
+  }
+  update(wave_values);
+  start_wave();
+  return true;
+}
+
+void PolicySearch::start_wave() {
+  int count = 0;
+  while (true) {
+    wave.clear();
+    next_wave(wave);
+    wave_values.assign(wave.size(), 0);
+    wave_reported.assign(wave.size(), false);
+    n_reported = 0;
+
+    for (size_t r = 0; r < resumed.size(); ++r) {
+      for (size_t i = 0; i < wave.size(); ++i) {
+        if (!wave_reported[i] && wave[i] == resumed[r].first) {
+          wave_values[i] = resumed[r].second;
+          wave_reported[i] = true;
+          n_reported++;
+          break;
+        }
+      }
+    }
+    resumed.clear();
+
+    if (n_reported < wave_size()) {
+      break;
+    }
+
+    // Nothing to evaluate, the update can be done right away
+    update(wave_values);
+    count++;
+    if ( count >= n_policy * 100 ) {
+      std::cout << "##### FINISHED (looped policies) #####\n";
+      exit(0);
+    }
+  }
+  save_checkpoint();
+}
+
+void PolicySearch::load_policy() {
+  std::ifstream f(policy_file_name.c_str());
+  if ( f.good() && policy_file_name != "" ) {
+    std::istream_iterator<float> start(f), end;
+    std::vector<float> file_policy(start, end);
+    if ((int)file_policy.size() == n_policy) {
+      policy = file_policy;
+    } else {
+      std::cerr << policy_file_name << " has " << file_policy.size()
+                << " weights, not " << n_policy << ". Not using it\n";
+    }
+  }
+  f.close();
+}
+
+void PolicySearch::save_policy(const std::vector<float> &p) const {
+  if ( policy_file_name != "" ) { // Save the current best policy to file
+    std::ofstream f(policy_file_name.c_str());
+    if ( f.good() ) {
+      std::ostream_iterator<float> output_iterator(f, " ");
+      std::copy(p.begin(), p.end(), output_iterator);
+    }
+    f.close();
+  }
+}
+
+bool PolicySearch::resume() {
+  if (checkpoint_file_name == "") {
+    return false;
+  }
+  std::ifstream f(checkpoint_file_name.c_str());
+  std::string header;
+  int size, reported;
+  if ( !(f >> header >> size) || header != CHECKPOINT_HEADER ||
+       size != n_policy ) {
+    return false;
+  }
+
+  std::vector<float> p(n_policy);
+  for (int i = 0; i < n_policy; ++i) {
+    f >> p[i];
+  }
+  f >> reported;
+
+  std::vector<std::pair<std::vector<float>, float> > values(
+    std::max(reported, 0), std::make_pair(std::vector<float>(n_policy), 0.0f));
+  for (int r = 0; r < reported; ++r) {
+    f >> values[r].second;
+    for (int i = 0; i < n_policy; ++i) {
+      f >> values[r].first[i];
+    }
+  }
+  if ( f.fail() || !load_state(f) ) {
+    std::cerr << "Cannot read checkpoint " << checkpoint_file_name << "\n";
+    return false;
+  }
+
+  policy = p;
+  resumed = values;
+  std::cout << "Resumed policy = " << policy << " with " << reported
+            << " returns of its wave\n";
+  return true;
+}
+
+void PolicySearch::save_checkpoint() const {
+  if (checkpoint_file_name == "") {
+    return;
+  }
+
+  // Written next to it and renamed over it, so that a run killed while
+  // writing leaves the previous checkpoint in place.
+  std::string temp_file_name = checkpoint_file_name + ".tmp";
+  std::ofstream f(temp_file_name.c_str(), std::ios::trunc);
+  if ( !f.good() ) {
+    return;
+  }
+  // Enough digits for a float to be read back exactly
+  f << std::setprecision(9);
+  f << CHECKPOINT_HEADER << " " << n_policy << "\n";
+  std::ostream_iterator<float> output_iterator(f, " ");
+  std::copy(policy.begin(), policy.end(), output_iterator);
+  f << "\n" << n_reported << "\n";
+  for (size_t i = 0; i < wave.size(); ++i) {
+    if (wave_reported[i]) {
+      f << wave_values[i] << " ";
+      std::copy(wave[i].begin(), wave[i].end(), output_iterator);
+      f << "\n";
+    }
+  }
+  save_state(f);
+  f.close();
+
+  if ( f.fail() || rename(temp_file_name.c_str(),
+                          checkpoint_file_name.c_str()) != 0 ) {
+    std::cerr << "Cannot save checkpoint " << checkpoint_file_name << "\n";
+  }
+}
@@ -0,0 +1,79 @@
+#include <rl_agent/Spsa.hh>
+#include <rl_agent/policy/LinearPolicy.h>
+
+#include <cstring>
+
+Spsa::Spsa(long sd, int directions, Policy* model, int instance)
+  : PolicySearch(model != NULL ? model : new LinearPolicy(8, 4), 0.90) {
+  seed = sd;
+  n_directions = std::max(directions, 1);
+
+  // Same scale as Pegasus: a pair of returns that differ by 1 moves the
+  // policy by policy_stepsize along the direction.
+  policy_stepsize = 0.0001;
+  policy_change = 0.01;
+  policy_file_name = instance_file_name("policy.txt", instance);
+  checkpoint_file_name = instance_file_name("spsa_checkpoint.txt", instance);
+
+  init_policy();
+  start_wave();
+}
+
+int Spsa::init_policy() {
+  load_policy();
+
+  std::cout << "Initialized policy = " << policy << "\n";
+  resume();
+  return n_policy;
+}
+
+void Spsa::next_wave(std::vector<std::vector<float> > &wave) {
+  // The directions only depend on the seed and the policy, so a resumed
+  // run evaluates the same wave again.
+  uint64_t scenario = 14695981039346656037ULL;
+  for (int i = 0; i < n_policy; ++i) {
+    uint32_t bits;
+    memcpy(&bits, &policy[i], sizeof(bits));
+    scenario = (scenario ^ bits) * 1099511628211ULL;
+  }
+  ScenarioRng rng(seed, scenario, ScenarioRng::PERTURBATIONS);
+
+  deltas.assign(n_directions, std::vector<float>(n_policy));
+  for (int d = 0; d < n_directions; ++d) {
+    std::vector<float> plus = policy, minus = policy;
+    for (int i = 0; i < n_policy; ++i) {
+      deltas[d][i] = (rng.next() & 1) ? 1 : -1;
+      plus[i] += policy_change * deltas[d][i];
+      minus[i] -= policy_change * deltas[d][i];
+    }
+    wave.push_back(plus);
+    wave.push_back(minus);
+  }
+}
+
+void Spsa::update(const std::vector<float> &values) {
+  std::vector<float> old_policy = policy, new_policy = policy;
+
+  float mean_value = 0;
+  for (int d = 0; d < n_directions; ++d) {
+    float plus_value = values[2 * d], minus_value = values[2 * d + 1];
+    mean_value += (plus_value + minus_value) / (2 * n_directions);
+
+    float gradient = (plus_value - minus_value);
+    for (int i = 0; i < n_policy; ++i) {
+      new_policy[i] += gradient * deltas[d][i] * policy_stepsize / n_directions;
+    }
+  }
+
+  std::cout << "Mean value around policy = " << mean_value << "\n";
+  std::cout << "Switching policy -----------------------------------\n";
+  std::cout << "Old policy " << old_policy << "\n"
+            << "New policy " << new_policy << "\n";
+  if ( old_policy == new_policy ) {
+    std::cout << "##### FINISHED (same policy got) #####\n";
+    exit(0);
+  }
+  policy = new_policy;
+
+  save_policy(policy);
+}
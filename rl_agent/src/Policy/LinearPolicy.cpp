@@ -0,0 +1,34 @@
+#include <cassert>
+#include <sstream>
+
+#include <rl_agent/policy/LinearPolicy.h>
+
+LinearPolicy::LinearPolicy(int ns, int na) {
+    n_state = ns;
+    n_action = na;
+    assert(n_state == 2 * n_action);
+    weights.resize(n_state, 0.0);
+}
+
+void LinearPolicy::set_weights(const std::vector<float> &w) {
+    assert(w.size() == weights.size());
+    weights = w;
+}
+
+void LinearPolicy::get_value(const std::vector<float> &input, std::vector<float> &output) {
+    assert((int)input.size() == n_state);
+    output.resize(n_action);
+    get_action(&weights[0], &input[0], &output[0]);
+}
+
+void LinearPolicy::get_action(const float* p, const float* s, float* action) {
+    for(int i=0; i<n_action; ++i) {
+        action[i] = p[2 * i] * s[2 * i] + p[2 * i + 1] * s[2 * i + 1];
+    }
+}
+
+std::string LinearPolicy::configuration() const {
+    std::stringstream c;
+    c << "linear " << n_state << "-" << n_action;
+    return c.str();
+}
@@ -1,126 +1,151 @@
+#include <sstream>
+
 #include <rl_agent/policy/NeuralNetwork.h>
 
-Neuron::Neuron(int n) {
-    n_inputs = n;
-    weights.resize(n);
-    for(int i=0; i<n+1; ++i) {
-    	float k = random_weight();
-        weights[i] = k;         //Insert random number
+NeuralNetwork::NeuralNetwork(int n_i, int n_o, int n_h, int n_per_h, long seed,
+                             Activation hidden, Activation output) {
+    n_inputs = n_i;
+    n_outputs = n_o;
+    n_per_hidden_layer = n_per_h;
+    n_hidden_layers = n_h;
+
+    // Hidden layers, then the output layer
+    int next_inp = n_inputs;
+    int n_weights = 0;
+    for(int i=0; i<=n_hidden_layers; ++i) {
+        Layer layer;
+        layer.n_in = next_inp;
+        layer.n_out = (i < n_hidden_layers) ? n_per_hidden_layer : n_outputs;
+        layer.offset = n_weights;
+        layer.activation = (i < n_hidden_layers) ? hidden : output;
+        layers.push_back(layer);
+        outputs.push_back(Eigen::VectorXf::Zero(layer.n_out));
+        batch_outputs.push_back(std::vector<float>());
+
+        n_weights += layer.n_out * (layer.n_in + 1);
+        next_inp = layer.n_out;
     }
-}
 
-float Neuron::random_weight(float min_w, float max_w) {
-    float w = min_w + static_cast <float> (rand()) /( static_cast <float> (RAND_MAX/(max_w-min_w)));
-    return w;
-}
+    batch_capacity = 0;
 
-float Neuron::get_output(std::vector<float> inp) {
-    float output = 0;
-    for(int i=0; i<inp.size(); ++i) {
-        output += inp[i] * weights[i];
+    // Random numbers of the initial weights
+    ScenarioRng rng(seed, 0, ScenarioRng::WEIGHTS);
+    weights.resize(n_weights);
+    for(int i=0; i<n_weights; ++i) {
+        weights[i] = rng.uniform(-0.1, 0.1);
     }
-    output += weights[n_inputs];
-    return activate(output);
 }
 
-float Neuron::activate(float inp) {
-    return sigmoid(inp);
+void NeuralNetwork::get_weights(std::vector<float> &w) const {
+    w = weights;
 }
 
-NeuralLayer::NeuralLayer(int n, int inp) {
-    n_neurons = n;
-    std::vector<Neuron> v;
-    for(int i=0; i<n_neurons; ++i) {
-        v.push_back(Neuron(inp));
-    }
-    neurons = v;
+void NeuralNetwork::set_weights(const std::vector<float> &w) {
+    assert(w.size() == weights.size());
+    weights = w;
 }
 
-std::vector<float> NeuralLayer::get_outputs(std::vector<float> inp) {
-    std::vector<float> v(n_neurons);
-    for(int i=0; i<n_neurons; ++i) {
-       v[i] = neurons[i].get_output(inp);
-    }
-    return v;
+void NeuralNetwork::get_value(const std::vector<float> &input, std::vector<float> &output) {
+    assert((int)input.size() == n_inputs);
+    const float* out = forward(&input[0]);
+    output.assign(out, out + n_outputs);
 }
 
-NeuralNetwork::NeuralNetwork(int n_i, int n_o, int n_h, int n_per_h) {
-    n_inputs = n_i;
-    n_outputs = n_o;
-    n_per_hidden_layer = n_per_h;
-    n_hidden_layers = n_h;
-
-    // Initialize random seed generator
+const float* NeuralNetwork::forward(const float* input) {
+    const float* in = input;
+    for(size_t l=0; l<layers.size(); ++l) {
+        const Layer &layer = layers[l];
+        Eigen::Map<const LayerMatrix> w(&weights[layer.offset], layer.n_out, layer.n_in + 1);
+        Eigen::Map<const Eigen::VectorXf> x(in, layer.n_in);
 
-    srand(time(NULL));
+        Eigen::VectorXf &out = outputs[l];
+        out.noalias() = w.leftCols(layer.n_in) * x;
+        out += w.col(layer.n_in);
+        activate(out, layer.activation);
 
-    // Create the input layer
-    NeuralLayer input_layer = NeuralLayer(n_inputs, 0);
-    layers.push_back(input_layer);
-
-    // Number of inputs for next layer
-    int next_inp = n_inputs;
-    for(int i=0; i<n_hidden_layers; ++i) {
-        layers.push_back(NeuralLayer(n_per_hidden_layer, next_inp));
-        next_inp = n_per_hidden_layer;
+        // Next input comes from output of this layer
+        in = out.data();
     }
+    return in;
+}
 
-    NeuralLayer output_layer = NeuralLayer(n_outputs, next_inp);
-    layers.push_back(output_layer);
-
-    weights.resize(get_n_weights());
-    get_weights(weights);
+void NeuralNetwork::get_action(const float* w, const float* state, float* action) {
+    run_batch(w, state, 1, action);
 }
 
-int NeuralNetwork::get_n_weights() {
-    return ((n_inputs+1)*n_per_hidden_layer + n_outputs*(n_per_hidden_layer+1) + (n_hidden_layers-1)*((n_per_hidden_layer+1)*n_per_hidden_layer));
+void NeuralNetwork::forward_batch(const float* inputs, int batch, float* out) {
+    run_batch(&weights[0], inputs, batch, out);
 }
 
-void  NeuralNetwork::get_weights(std::vector<float> &weights) {
-    // Faster method would be to keep a vector of weights here
-    // Unless the network is very big, speed shouldnt be an issue
-    int no=0;
-    for(std::vector<NeuralLayer>::iterator it=layers.begin(); it != layers.end(); ++it) {
-        // Skip the input layer
-        if(it != layers.begin()) {
-            std::vector<Neuron> neurons = it->neurons;
-            for(std::vector<Neuron>::iterator itn=neurons.begin(); itn != neurons.end(); ++itn) {
-                Neuron n = *itn;
-                for(int i=0; i<n.n_inputs+1; i++) {
-                    weights[no++] = n.weights[i];
-                }
-            }
-        }
+void NeuralNetwork::forward_population(const float* arena, int population,
+                                       const float* inputs, int batch,
+                                       int input_stride, float* out) {
+    int n_weights = weights.size();
+    for(int p=0; p<population; ++p) {
+        run_batch(arena + (size_t)p * n_weights, inputs + (size_t)p * input_stride,
+                  batch, out + (size_t)p * batch * n_outputs);
     }
 }
 
-void  NeuralNetwork::set_weights(std::vector<float> w) {
-    weights = w;
-    for(std::vector<NeuralLayer>::iterator it=layers.begin(); it != layers.end(); ++it) {
-        // Skip the input layer
-        int no=0;
-        if(it != layers.begin()) {
-            std::vector<Neuron> neurons = it->neurons;
-            for(std::vector<Neuron>::iterator itn=neurons.begin(); itn != neurons.end(); ++itn) {
-                Neuron n = *itn;
-                for(int i=0; i<n.n_inputs+1; i++) {
-                    n.weights[i] = weights[no++];
-                }
-            }
+void NeuralNetwork::run_batch(const float* w, const float* inputs, int batch, float* out) {
+    typedef Eigen::Map<const LayerMatrix> ConstBatch;
+    if (batch <= 0) {
+        return;
+    }
+    if (batch > batch_capacity) {
+        batch_capacity = batch;
+        for(size_t l=0; l<layers.size(); ++l) {
+            batch_outputs[l].resize((size_t)batch * layers[l].n_out);
         }
     }
-}
-
-void  NeuralNetwork::get_value(std::vector<float> &input, std::vector<float> &output) {
-    for(std::vector<NeuralLayer>::iterator it=layers.begin(); it != layers.end(); ++it) {
-        std::cout<<"Input at layer " << input << "\n";
 
-        output.clear();
-        output = it->get_outputs(input);
+    const float* in = inputs;
+    for(size_t l=0; l<layers.size(); ++l) {
+        const Layer &layer = layers[l];
+        ConstBatch layer_w(w + layer.offset, layer.n_out, layer.n_in + 1);
+        ConstBatch x(in, batch, layer.n_in);
+
+        // The last layer writes straight into the caller's array
+        float* y_data = (l + 1 == layers.size()) ? out : &batch_outputs[l][0];
+        Eigen::Map<LayerMatrix> y(y_data, batch, layer.n_out);
+        y.noalias() = x * layer_w.leftCols(layer.n_in).transpose();
+        y.rowwise() += layer_w.col(layer.n_in).transpose();
+        Eigen::Map<Eigen::VectorXf> y_all(y_data, (size_t)batch * layer.n_out);
+        activate(y_all, layer.activation);
+
+        in = y_data;
+    }
+}
 
-        // Next input comes from output of this layer
-        input = output;
+std::string NeuralNetwork::configuration() const {
+    static const char* names[] = {"linear", "sigmoid", "fast_sigmoid", "tanh",
+                                  "relu"};
+    std::stringstream c;
+    c << "neural " << n_inputs;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        c << "-" << layers[i].n_out;
+    }
+    for (size_t i = 0; i < layers.size(); ++i) {
+        c << " " << names[layers[i].activation];
+    }
+    return c.str();
+}
 
-        std::cout<<"Output at layer " << output << "\n";
+void NeuralNetwork::activate(Eigen::Ref<Eigen::VectorXf> x, Activation activation) {
+    switch(activation) {
+    case SIGMOID:
+        x.array() = (1.0f + (-x.array()).exp()).inverse();
+        break;
+    case FAST_SIGMOID:
+        x.array() = 0.5f * (0.5f * x.array()).tanh() + 0.5f;
+        break;
+    case TANH:
+        x.array() = x.array().tanh();
+        break;
+    case RELU:
+        x = x.cwiseMax(0.0f);
+        break;
+    case LINEAR:
+        break;
     }
 }
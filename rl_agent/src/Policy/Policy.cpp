@@ -0,0 +1,15 @@
+#include <rl_agent/policy/Policy.h>
+#include <rl_agent/policy/LinearPolicy.h>
+#include <rl_agent/policy/NeuralNetwork.h>
+
+Policy* Policy::create(const std::string &type, int n_state, int n_action,
+                       int hidden, long seed) {
+    if (type == "linear") {
+        return new LinearPolicy(n_state, n_action);
+    } else if (type == "neural") {
+        // The actions are velocities, so the output layer is linear
+        return new NeuralNetwork(n_state, n_action, hidden > 0 ? 1 : 0, hidden,
+                                 seed, TANH, LINEAR);
+    }
+    return NULL;
+}
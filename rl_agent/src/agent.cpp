@@ -1,7 +1,9 @@
 #include <getopt.h>
+#include <stdlib.h>
 #include <ros/ros.h>
 
 #include <rl_common/core.hh>
+#include <rl_common/shm_transport.hh>
 
 // Messages
 #include <rl_common/RLStateReward.h>
@@ -10,6 +12,9 @@
 
 // Agents
 #include <rl_agent/Pegasus.hh>
+#include <rl_agent/Spsa.hh>
+#include <rl_agent/Cmaes.hh>
+#include <rl_agent/policy/Policy.h>
 
 static ros::Publisher out_rl_action;
 static ros::Publisher out_exp_info;
@@ -18,24 +23,76 @@ static ros::Publisher out_exp_info;
 const int MAX_STEPS = 10000;
 Agent* agent = NULL;
 int seed = 1;
+int directions = 4; // Perturbations per update of spsa
+int population = 0; // Of cmaes. 0 = its default
+std::string policy_type = "linear"; // Family of the policies searched
+int hidden = 8; // Units of the hidden layer of the neural policy
 
 rl_common::RLExperimentInfo info;
 std::string agent_type = "";
+std::string transport = "ros"; // "ros" topics or "shm" shared memory
+ShmTransport* shm = NULL;
 
 void display_help(){
   std::cout << "\n agent --agent type [options]\n";
   std::cout << "\n Options:\n";
-  std::cout << "--agent type (Agent types: pegasus)\n";
+  std::cout << "--agent type (Agent types: pegasus, spsa, cmaes)\n";
+  std::cout << "--seed value (Of the wind scenarios, the spsa directions and\n"
+            << "   the cmaes samples. The env node draws the scenarios, give\n"
+            << "   it the same --seed. Default: 1)\n";
+  std::cout << "--directions k (Antithetic pairs per spsa update. Default: 4)\n";
+  std::cout << "--population n (Of the first cmaes generation.\n"
+            << "   Default: 4 + 3 ln(number of parameters))\n";
+  std::cout << "--policy type (Policies searched: linear (8 gains) or neural.\n"
+            << "   Default: linear)\n";
+  std::cout << "--hidden n (Units of the hidden layer of the neural policy,\n"
+            << "   0 for none. Default: 8)\n";
+  std::cout << "--transport type (ros or shm. Default: ros)\n";
   exit(-1);
 }
 
+Policy* create_policy() {
+  Policy* policy = Policy::create(policy_type, 8, 4, hidden, seed);
+  if (policy == NULL) {
+    std::cout << "Invalid Policy!" << std::endl;
+    display_help();
+  }
+  return policy;
+}
+
+// Set by the env before it sends its first state, see
+// HectorQuad::configuration
+std::string environment_configuration() {
+  std::string configuration;
+  ros::param::get("/rl_env/configuration", configuration);
+  return configuration;
+}
+
+// The scenarios are drawn in the env node, from its own --seed. Both nodes
+// have to be given the same one, as rl_runner gives its --seed to both.
+void check_seed(const std::string &configuration) {
+  size_t at = configuration.find(" seed=");
+  if (at != std::string::npos &&
+      std::atol(configuration.c_str() + at + 6) != seed) {
+    ROS_WARN("RL AGENT: the env runs the scenarios of another --seed: %s",
+             configuration.c_str());
+  }
+}
+
 void init_agent() {
   agent = NULL;
+  std::string configuration = environment_configuration();
+  check_seed(configuration);
 
   if (agent_type == "pegasus"){
     std::cout << "Agent: Pegasus" << std::endl;
-    // For now, we arent using these args. Theyre reset in the constructor
-    agent = new Pegasus();
+    agent = new Pegasus(create_policy(), configuration);
+  } else if (agent_type == "spsa") {
+    std::cout << "Agent: SPSA" << std::endl;
+    agent = new Spsa(seed, directions, create_policy());
+  } else if (agent_type == "cmaes") {
+    std::cout << "Agent: CMA-ES" << std::endl;
+    agent = new Cmaes(seed, population, create_policy());
   } else {
     std::cout << "Invalid Agent!" << std::endl;
     display_help();
@@ -44,24 +101,24 @@ void init_agent() {
   info.number_actions = 0;
 }
 
-void process_state(const rl_common::RLStateReward::ConstPtr &state_in){
-  /** Process the state/reward message from the environment */
+bool process(const std::vector<float> &state, float reward, bool terminal,
+             std::vector<float> &action) {
+  /** Process the state/reward from the environment.
+      Returns false if the episode ended and there is no action to send. */
 
   if (agent == NULL) {
     init_agent();
   }
 
-  rl_common::RLAction msg;
-
   if (info.number_actions == 0) {
-    msg.action = agent->first_action(state_in->state);
+    action = agent->first_action(state);
     info.episode_reward = 0;
     info.number_actions += 1;
 
-  } else if (state_in->terminal /*|| info.number_actions > MAX_STEPS*/) {
-    info.episode_reward += state_in->reward;
+  } else if (terminal /*|| info.number_actions > MAX_STEPS*/) {
+    info.episode_reward += reward;
     info.episode_number += 1;
-    agent->last_action(state_in->reward);
+    agent->last_action(reward);
     out_exp_info.publish(info); // Publish end of episode message
 
     // std::cout << "RL AGENT: Episode " << info.episode_number
@@ -70,15 +127,47 @@ void process_state(const rl_common::RLStateReward::ConstPtr &state_in){
 
     info.number_actions = 0;
     info.episode_reward = 0;
-    return;
+    return false;
 
   } else {
-    info.episode_reward += state_in->reward;
+    info.episode_reward += reward;
     info.number_actions += 1;
-    msg.action = agent->next_action(state_in->reward, state_in->state);
+    action = agent->next_action(reward, state);
+  }
+
+  return true;
+}
+
+void process_state(const rl_common::RLStateReward::ConstPtr &state_in){
+  rl_common::RLAction msg;
+  if (process(state_in->state, state_in->reward, state_in->terminal,
+              msg.action)) {
+    out_rl_action.publish(msg);
   }
+}
+
+void shm_loop() {
+  // Same as the subscriber, but reading from shared memory. The end of an
+  // episode is also sent through it, as the env does not listen to
+  // rl_experiment_info in this mode.
+  ShmStepRecord record;
+  std::vector<float> state(SHM_STATE_SIZE), action;
 
-  out_rl_action.publish(msg);
+  while (ros::ok()) {
+    if (!shm->receive(record, 100)) {
+      ros::spinOnce();
+      continue;
+    }
+
+    state.assign(record.state, record.state + SHM_STATE_SIZE);
+    if (process(state, record.reward, record.terminal, action)) {
+      record.kind = ShmStepRecord::ACTION;
+      ShmTransport::set_action(record, action);
+    } else {
+      record.kind = ShmStepRecord::EPISODE_END;
+    }
+    shm->send(record);
+  }
 }
 
 int main(int argc, char *argv[]) {
@@ -86,11 +175,16 @@ int main(int argc, char *argv[]) {
   ros::NodeHandle node;
 
   char ch;
-  const char* optflags = "as";
+  const char* optflags = "astdolh";
   int option_index = 0;
   static struct option long_options[] = {
     {"seed", 1, 0, 's'},
     {"agent", 1, 0, 'a'},
+    {"transport", 1, 0, 't'},
+    {"directions", 1, 0, 'd'},
+    {"population", 1, 0, 'o'},
+    {"policy", 1, 0, 'l'},
+    {"hidden", 1, 0, 'h'},
     {NULL, 0, 0, 0}
   };
 
@@ -107,13 +201,35 @@ int main(int argc, char *argv[]) {
       std::cout << "Using agent: " << agent_type << "\n";
       break;
 
+    case 't':
+      transport = optarg;
+      std::cout << "Using transport: " << transport << "\n";
+      break;
+
+    case 'd':
+      directions = std::atoi(optarg);
+      break;
+
+    case 'o':
+      population = std::atoi(optarg);
+      break;
+
+    case 'l':
+      policy_type = optarg;
+      std::cout << "Using policy: " << policy_type << "\n";
+      break;
+
+    case 'h':
+      hidden = std::atoi(optarg);
+      break;
+
     default:
       display_help();
       break;
     }
   }
 
-  if (agent_type == "") {
+  if (agent_type == "" || (transport != "ros" && transport != "shm")) {
     display_help();
   }
 
@@ -127,6 +243,14 @@ int main(int argc, char *argv[]) {
     1,
     false);
 
+  if (transport == "shm") {
+    shm = new ShmTransport(SHM_DEFAULT_NAME, ShmTransport::AGENT);
+    ROS_INFO("RL AGENT: starting shared memory loop");
+    shm_loop();
+    delete shm;
+    return 0;
+  }
+
   // Subscribers
   ros::TransportHints no_delay = ros::TransportHints().tcpNoDelay(true);
   ros::Subscriber rl_state =  node.subscribe("rl_env/rl_state_reward",
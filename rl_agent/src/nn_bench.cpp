@@ -0,0 +1,234 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include <rl_agent/policy/NeuralNetwork.h>
+#include <rl_agent/policy/FixedNetwork.h>
+
+#include <getopt.h>
+#include <stdlib.h>
+
+// Microbenchmark of one NeuralNetwork inference for controller sized
+// networks: 8 state inputs and 4 actions, with no or small hidden layers.
+// Compares the forward pass against a plain loop over the same flat weights
+// (one dot product per neuron), which is also used to check the outputs.
+// Then the same for batches of states under one network, and for one state
+// under each network of a population, as vectorized rollouts and population
+// based search use them. Last, the compile time shaped FixedNetwork against
+// a NeuralNetwork with the same weights.
+// Build with optimizations (eg. -DCMAKE_BUILD_TYPE=Release) for meaningful
+// numbers.
+
+int iterations = 1000000;
+
+// Plain per-neuron loops, with the exact sigmoid
+void reference(const std::vector<float> &weights,
+               const std::vector<int> &sizes, const std::vector<float> &input,
+               std::vector<float> &output, bool sigmoid) {
+  std::vector<float> in = input;
+  int offset = 0;
+  for (size_t l = 1; l < sizes.size(); ++l) {
+    output.assign(sizes[l], 0);
+    for (int o = 0; o < sizes[l]; ++o) {
+      float sum = 0;
+      for (int i = 0; i < sizes[l - 1]; ++i) {
+        sum += weights[offset++] * in[i];
+      }
+      sum += weights[offset++];
+      output[o] = sigmoid ? 1 / (1 + exp(-sum)) : sum;
+    }
+    in = output;
+  }
+}
+
+void bench(int n_hidden, int n_per_hidden, Activation activation,
+           const std::string &activation_name) {
+  NeuralNetwork network(8, 4, n_hidden, n_per_hidden, 1, activation, activation);
+  std::vector<int> sizes(1, 8);
+  for (int h = 0; h < n_hidden; ++h) sizes.push_back(n_per_hidden);
+  sizes.push_back(4);
+
+  std::vector<float> input(8);
+  for (int i = 0; i < 8; ++i) input[i] = 0.1 * (i - 4);
+
+  // Different inputs every iteration, so that nothing is hoisted
+  float sink = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int k = 0; k < iterations; ++k) {
+    input[k & 7] += 1e-6;
+    sink += network.forward(&input[0])[0];
+  }
+  double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  std::vector<float> weights, expected, output;
+  network.get_weights(weights);
+  double reference_elapsed = 0, error = 0;
+  if (activation == SIGMOID || activation == LINEAR) {
+    start = std::chrono::steady_clock::now();
+    for (int k = 0; k < iterations; ++k) {
+      input[k & 7] += 1e-6;
+      reference(weights, sizes, input, expected, activation == SIGMOID);
+      sink += expected[0];
+    }
+    reference_elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+    network.get_value(input, output);
+    for (int o = 0; o < 4; ++o) {
+      error = std::max(error, (double)fabs(output[o] - expected[o]));
+    }
+  }
+
+  std::cout << "8";
+  for (int h = 0; h < n_hidden; ++h) std::cout << "-" << n_per_hidden;
+  std::cout << "-4 " << activation_name << " (" << network.get_n_weights()
+            << " weights): " << 1e9 * elapsed / iterations << " ns/inference";
+  if (reference_elapsed > 0) {
+    std::cout << ", plain loops " << 1e9 * reference_elapsed / iterations
+              << " ns, max difference " << error;
+  }
+  std::cout << (sink == 12345 ? " " : "") << "\n";
+}
+
+void bench_batch(int n_hidden, int n_per_hidden, int batch, int population) {
+  NeuralNetwork network(8, 4, n_hidden, n_per_hidden, 1, FAST_SIGMOID, SIGMOID);
+  int n_weights = network.get_n_weights();
+  std::vector<float> arena, weights;
+  for (int p = 0; p < population; ++p) {
+    NeuralNetwork member(8, 4, n_hidden, n_per_hidden, p + 1, FAST_SIGMOID, SIGMOID);
+    member.get_weights(weights);
+    arena.insert(arena.end(), weights.begin(), weights.end());
+  }
+
+  // population x batch states, each member gets its own
+  std::vector<float> inputs(population * batch * 8), outputs(population * batch * 4);
+  for (size_t i = 0; i < inputs.size(); ++i) inputs[i] = 0.01 * (i % 97) - 0.5;
+
+  long inferences = (long)population * batch;
+  int repeats = std::max(1L, iterations / inferences);
+  float sink = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int k = 0; k < repeats; ++k) {
+    inputs[k % inputs.size()] += 1e-6;
+    if (population == 1) {
+      network.forward_batch(&inputs[0], batch, &outputs[0]);
+    } else {
+      network.forward_population(&arena[0], population, &inputs[0], batch,
+                                 batch * 8, &outputs[0]);
+    }
+    sink += outputs[0];
+  }
+  double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  // The last state of the last member, one at a time
+  int p = population - 1;
+  if (population > 1) {
+    network.set_weights(std::vector<float>(arena.begin() + p * n_weights,
+                                           arena.begin() + (p + 1) * n_weights));
+  }
+  const float* expected = network.forward(&inputs[(p * batch + batch - 1) * 8]);
+  double error = 0;
+  for (int o = 0; o < 4; ++o) {
+    error = std::max(error, (double)fabs(outputs[(p * batch + batch - 1) * 4 + o] - expected[o]));
+  }
+
+  std::cout << "8";
+  for (int h = 0; h < n_hidden; ++h) std::cout << "-" << n_per_hidden;
+  std::cout << "-4, " << population << " networks x " << batch << " states: "
+            << 1e9 * elapsed / (repeats * inferences) << " ns/inference"
+            << ", max difference to forward() " << error
+            << (sink == 12345 ? " " : "") << "\n";
+}
+
+template <int... Sizes>
+void bench_fixed(int n_hidden, int n_per_hidden, const std::string &shape) {
+  NeuralNetwork network(8, 4, n_hidden, n_per_hidden, 1, FAST_SIGMOID, SIGMOID);
+  std::vector<float> weights;
+  network.get_weights(weights);
+  FixedNetwork<Sizes...> fixed(FAST_SIGMOID, SIGMOID);
+  fixed.set_weights(weights);
+
+  std::vector<float> input(8);
+  for (int i = 0; i < 8; ++i) input[i] = 0.1 * (i - 4);
+
+  float output[4], sink = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int k = 0; k < iterations; ++k) {
+    input[k & 7] += 1e-6;
+    fixed.forward(&input[0], output);
+    sink += output[0];
+  }
+  double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (int k = 0; k < iterations; ++k) {
+    input[k & 7] += 1e-6;
+    sink += network.forward(&input[0])[0];
+  }
+  double network_elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  fixed.forward(&input[0], output);
+  const float* expected = network.forward(&input[0]);
+  double error = 0;
+  for (int o = 0; o < 4; ++o) {
+    error = std::max(error, (double)fabs(output[o] - expected[o]));
+  }
+
+  std::cout << "FixedNetwork<" << shape << "> (" << fixed.n_weights
+            << " weights): " << 1e9 * elapsed / iterations << " ns/inference"
+            << ", NeuralNetwork " << 1e9 * network_elapsed / iterations
+            << " ns, max difference " << error
+            << (sink == 12345 ? " " : "") << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  char ch;
+  const char* optflags = "n";
+  int option_index = 0;
+  static struct option long_options[] = {
+    {"n", 1, 0, 'n'},
+    {NULL, 0, 0, 0}
+  };
+
+  while(-1 != (ch = getopt_long_only(argc, argv, optflags, long_options, &option_index))) {
+    switch(ch) {
+    case 'n':
+      iterations = std::max(1, std::atoi(optarg));
+      break;
+    default:
+      std::cout << "\n nn_bench [--n iterations]\n";
+      exit(-1);
+    }
+  }
+
+  bench(0, 0, LINEAR, "linear");
+  bench(0, 0, SIGMOID, "sigmoid");
+  bench(0, 0, FAST_SIGMOID, "fast_sigmoid");
+  bench(1, 8, SIGMOID, "sigmoid");
+  bench(1, 8, FAST_SIGMOID, "fast_sigmoid");
+  bench(1, 16, SIGMOID, "sigmoid");
+  bench(1, 16, FAST_SIGMOID, "fast_sigmoid");
+  bench(2, 32, SIGMOID, "sigmoid");
+  bench(2, 32, FAST_SIGMOID, "fast_sigmoid");
+  bench(2, 32, RELU, "relu");
+
+  int batches[] = {1, 16, 256, 4096};
+  for (int b = 0; b < 4; ++b) {
+    bench_batch(0, 0, batches[b], 1);
+    bench_batch(1, 16, batches[b], 1);
+    bench_batch(2, 32, batches[b], 1);
+  }
+  bench_batch(0, 0, 1, 1024);
+  bench_batch(1, 16, 1, 1024);
+  bench_batch(1, 16, 16, 256);
+
+  bench_fixed<8, 4>(0, 0, "8, 4");
+  bench_fixed<8, 16, 4>(1, 16, "8, 16, 4");
+  bench_fixed<8, 16, 16, 4>(2, 16, "8, 16, 16, 4");
+  bench_fixed<8, 32, 32, 4>(2, 32, "8, 32, 32, 4");
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include <unistd.h>
+
+#include <rl_agent/PolicyCache.hh>
+
+// All the parameters of an 8 gain policy at `gain`
+static std::vector<float> gains(float gain) {
+  return std::vector<float>(8, gain);
+}
+
+// A new empty file for a log, that the test removes
+static std::string new_log() {
+  char name[] = "/tmp/policy_cache_XXXXXX";
+  close(mkstemp(name));
+  return name;
+}
+
+TEST(PolicyCache, FindsInsertedPolicies) {
+  PolicyCache cache(8, 1e-6, 10);
+  float value;
+  EXPECT_FALSE(cache.find(gains(0.5f), value));
+  cache.insert(gains(0.5f), 3);
+  ASSERT_TRUE(cache.find(gains(0.5f), value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(1, cache.hit_count());
+  EXPECT_EQ(1, cache.miss_count());
+}
+
+TEST(PolicyCache, PoliciesWithinTheQuantumAreTheSame) {
+  PolicyCache cache(8, 1e-3, 10);
+  cache.insert(gains(0.5f), 3);
+  float value;
+  EXPECT_TRUE(cache.find(gains(0.5002f), value));
+  EXPECT_FALSE(cache.find(gains(0.502f), value));
+}
+
+TEST(PolicyCache, DropsTheLeastRecentlyUsed) {
+  PolicyCache cache(8, 1e-6, 2);
+  float value;
+  cache.insert(gains(1), 1);
+  cache.insert(gains(2), 2);
+  ASSERT_TRUE(cache.find(gains(1), value)); // 2 is now the oldest
+  cache.insert(gains(3), 3);
+
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_TRUE(cache.find(gains(1), value));
+  EXPECT_FALSE(cache.find(gains(2), value));
+  EXPECT_TRUE(cache.find(gains(3), value));
+}
+
+TEST(PolicyCache, ReplaysItsLog) {
+  std::string log = new_log();
+  {
+    PolicyCache cache(8, 1e-6, 10, log);
+    cache.insert(gains(1), 1);
+    cache.insert(gains(2), 2);
+    cache.insert(gains(1), 5); // The last value is the one kept
+  }
+
+  PolicyCache cache(8, 1e-6, 10, log);
+  EXPECT_EQ(2u, cache.size());
+  float value;
+  ASSERT_TRUE(cache.find(gains(1), value));
+  EXPECT_EQ(5, value);
+  ASSERT_TRUE(cache.find(gains(2), value));
+  EXPECT_EQ(2, value);
+  remove(log.c_str());
+}
+
+TEST(PolicyCache, IgnoresTheLogOfAnotherPolicy) {
+  std::string log = new_log();
+  {
+    PolicyCache cache(8, 1e-6, 10, log);
+    cache.insert(gains(1), 1);
+  }
+  EXPECT_EQ(0u, PolicyCache(8, 1e-3, 10, log).size());
+  EXPECT_EQ(0u, PolicyCache(4, 1e-6, 10, log).size());
+  remove(log.c_str());
+}
+
+TEST(PolicyCache, DropsARecordCutShort) {
+  std::string log = new_log();
+  {
+    PolicyCache cache(8, 1e-6, 10, log);
+    cache.insert(gains(1), 1);
+    cache.insert(gains(2), 2);
+  }
+  // As if the run was killed in the middle of the last record
+  std::ifstream in(log.c_str(), std::ios::binary | std::ios::ate);
+  ASSERT_EQ(0, truncate(log.c_str(), (long)in.tellg() - 4));
+
+  float value;
+  {
+    PolicyCache cache(8, 1e-6, 10, log);
+    EXPECT_TRUE(cache.find(gains(1), value));
+    EXPECT_FALSE(cache.find(gains(2), value));
+    cache.insert(gains(3), 3); // After the last whole record
+  }
+  PolicyCache cache(8, 1e-6, 10, log);
+  ASSERT_TRUE(cache.find(gains(3), value));
+  EXPECT_EQ(3, value);
+  remove(log.c_str());
+}
+
+TEST(PolicyCache, IgnoresTheLogOfAnotherConfiguration) {
+  std::string log = new_log();
+  {
+    PolicyCache cache(8, 1e-6, 10, log, "quadsim seed=1");
+    cache.insert(gains(1), 1);
+  }
+
+  float value;
+  {
+    PolicyCache cache(8, 1e-6, 10, log, "quadsim seed=2");
+    EXPECT_FALSE(cache.find(gains(1), value));
+    cache.insert(gains(2), 2); // Not written to the log of seed 1
+  }
+
+  PolicyCache cache(8, 1e-6, 10, log, "quadsim seed=1");
+  EXPECT_TRUE(cache.find(gains(1), value));
+  EXPECT_FALSE(cache.find(gains(2), value));
+  remove(log.c_str());
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
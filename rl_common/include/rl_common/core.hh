@@ -87,8 +87,9 @@ public:
       environment.  This method implies that the environment is
       currently in an initial state.
       \param s The initial sensation from the environment.
-      \return The action vector the agent wishes to take first. */
-  virtual std::vector<float> first_action(const std::vector<float> &s) = 0;
+      \return The action vector the agent wishes to take first, valid
+      until the next call to the agent. */
+  virtual const std::vector<float> &first_action(const std::vector<float> &s) = 0;
 
   /** Determines the next action that an agent takes in an environment
       and gives feedback for the previous action.  This method may
@@ -96,8 +97,9 @@ public:
       next_action.
       \param r The one-step reward resulting from the previous action.
       \param s The current sensation from the environment.
-      \return The action vector the agent wishes to take next. */
-  virtual std::vector<float> next_action(float r, const std::vector<float> &s) = 0;
+      \return The action vector the agent wishes to take next, valid
+      until the next call to the agent. */
+  virtual const std::vector<float> &next_action(float r, const std::vector<float> &s) = 0;
 
   /** Gives feedback for the last action taken.  This method may only
       be called if the last method called was first_action or
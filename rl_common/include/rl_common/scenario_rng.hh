@@ -0,0 +1,55 @@
+#ifndef _RLSCENARIORNG_H_
+#define _RLSCENARIORNG_H_
+
+#include <stdint.h>
+
+/** Random numbers of a PEGASUS scenario. The n-th number of a stream is a
+    hash of (seed, scenario, stream, n), so it does not depend on what was
+    drawn before, in which thread, or by which policy. Episodes that are
+    given the same scenario see exactly the same wind, which makes the
+    comparison of two policies free of the noise of the environment (common
+    random numbers).
+
+    Different uses of random numbers in a scenario take different streams,
+    so that eg. logging more samples does not shift the wind sequence. */
+class ScenarioRng {
+public:
+  enum Stream {
+    WIND = 0,
+    LOGGING = 1,
+    WEIGHTS = 2, // Initial weights of a policy
+    PERTURBATIONS = 3 // Search directions of a policy update
+  };
+
+  ScenarioRng(uint64_t seed = 1, uint64_t scenario = 0, uint64_t stream = 0);
+
+  /** Starts the stream of another scenario from its first number. */
+  void set_scenario(uint64_t scenario);
+  uint64_t get_scenario() const { return scenario; }
+  uint64_t get_seed() const { return seed; }
+
+  /** Numbers drawn since the start of the scenario. */
+  uint64_t draws() const { return counter; }
+
+  uint64_t next() { return at(key, counter++); }
+
+  /** Uniform in [0, 1) */
+  double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+  double uniform(double min, double max) {
+    return min + (max - min) * uniform();
+  }
+
+  /** Standard normal, from two uniforms (Box-Muller) */
+  double normal();
+
+  /** The n-th number of a stream, with the key of that stream. */
+  static uint64_t at(uint64_t key, uint64_t n);
+  static uint64_t stream_key(uint64_t seed, uint64_t scenario,
+                             uint64_t stream);
+
+private:
+  uint64_t seed, scenario, stream;
+  uint64_t key, counter;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef _RLSHMTRANSPORT_H_
+#define _RLSHMTRANSPORT_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Fixed sizes of the HectorQuad state and action, which is all that the
+// shared memory transport is used for.
+#define SHM_STATE_SIZE 8
+#define SHM_ACTION_SIZE 4
+#define SHM_RING_SIZE 16 // Has to be a power of 2
+
+#define SHM_DEFAULT_NAME "/rl_step_transport"
+
+/** One record of the rl_env <-> rl_agent exchange. It plays the role of
+    RLStateReward (env -> agent), RLAction and the end of episode
+    RLExperimentInfo (agent -> env). */
+struct ShmStepRecord {
+  enum Kind { STATE = 1, ACTION = 2, EPISODE_END = 3 };
+
+  uint32_t kind;
+  uint32_t terminal;
+  float reward;
+  float state[SHM_STATE_SIZE];
+  float action[SHM_ACTION_SIZE];
+};
+
+/** Single producer, single consumer ring of step records. The layout is
+    fixed since it is shared between processes. head is only written by
+    the producer and tail only by the consumer. head doubles as the futex
+    word that a consumer sleeps on. */
+struct ShmRing {
+  std::atomic<uint32_t> head;
+  std::atomic<uint32_t> waiting; // Non zero if the consumer may be asleep
+  char pad_head[56];
+  std::atomic<uint32_t> tail;
+  char pad_tail[60];
+  ShmStepRecord records[SHM_RING_SIZE];
+};
+
+/** Optional transport between rl_agent and rl_env over POSIX shared memory,
+    for when both nodes run on the same machine. The env side creates the
+    segment and the agent side attaches to it. Receiving spins for a while
+    and then blocks on a futex, so an idle peer does not burn a CPU.
+
+    A segment left behind by an env that crashed is never attached to: the
+    env always creates a new one, and the agent only attaches to a segment
+    whose env is still running. */
+class ShmTransport {
+public:
+  enum Role { ENV, AGENT };
+
+  /** \param name Name of the shared memory object (see shm_open).
+      \param role ENV creates (and later unlinks) the segment, replacing a
+      stale one. AGENT waits until a running env has created it. */
+  ShmTransport(const std::string &name, Role role);
+  ~ShmTransport();
+
+  /** Sends a record to the peer. Blocks only if the ring is full. */
+  void send(const ShmStepRecord &record);
+
+  /** Receives the next record from the peer.
+      \param timeout_ms Give up after this long. Negative waits forever.
+      \return false if the timeout expired. */
+  bool receive(ShmStepRecord &record, int timeout_ms = -1);
+
+  // Helpers to fill records from the vectors used by Agent / Environment
+  static void set_state(ShmStepRecord &record, const std::vector<float> &s);
+  static void set_action(ShmStepRecord &record, const std::vector<float> &a);
+
+private:
+  struct Segment {
+    uint32_t magic, version;
+    int32_t owner; // pid of the env that created it
+    char pad[52];
+    ShmRing to_agent, to_env;
+  };
+
+  std::string name;
+  Role role;
+  Segment* segment;
+  ShmRing *in, *out;
+
+  // Maps the segment of a running env, NULL if there is none yet
+  Segment* attach();
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef _RLSTAGEPROFILER_H_
+#define _RLSTAGEPROFILER_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define PROFILER_MAX_STAGES 32
+// Log-linear (HDR style) buckets: every power of 2 is split in
+// 2^PROFILER_SUB_BITS linear sub buckets, which bounds the relative error of
+// any recorded value to about 3%.
+#define PROFILER_SUB_BITS 5
+#define PROFILER_SUB_BUCKETS (1 << PROFILER_SUB_BITS)
+#define PROFILER_BUCKETS (60 * PROFILER_SUB_BUCKETS)
+
+/** Latency histograms of named stages of the step, eg. the run_sim service
+    call in HectorQuad::sensation. Each thread records into its own buckets,
+    which only it writes to, so recording takes no locks and no atomic
+    read-modify-write. Readers merge the buckets of all the threads.
+
+    Profiling is off by default. When off, a PROFILE_STAGE costs a load and
+    a branch. */
+class StageProfiler {
+public:
+  /** Summary of the merged histogram of one stage. Times are in
+      microseconds. */
+  struct Summary {
+    std::string stage;
+    uint64_t count;
+    double mean, p50, p90, p99, max;
+  };
+
+  static void enable(bool on = true) { enabled_flag = on; }
+  static bool enabled() {
+    return enabled_flag.load(std::memory_order_relaxed);
+  }
+
+  /** Returns the id of a stage, registering it the first time. */
+  static int stage(const std::string &name);
+
+  /** Adds one latency to a stage, in the buckets of the calling thread. */
+  static void record(int stage_id, uint64_t nanoseconds);
+
+  /** Merges the histograms of all threads. Stages with no samples are left
+      out. */
+  static std::vector<Summary> summaries();
+
+  /** Prints all the summaries as a table. */
+  static void dump(std::ostream &out);
+
+  /** Publishes the summaries as rl_common/RLStageLatency on the given topic
+      every `period` seconds, from a separate thread. Needs ros::init. */
+  static void start_publishing(const std::string &topic, double period);
+  static void stop_publishing();
+
+  // Bucket <-> value (in ns) mapping
+  static int bucket(uint64_t value);
+  static uint64_t bucket_value(int bucket);
+
+private:
+  static std::atomic<bool> enabled_flag;
+};
+
+/** Times the scope it lives in and records it to a stage. */
+class StageTimer {
+public:
+  explicit StageTimer(int stage_id) {
+    id = StageProfiler::enabled() ? stage_id : -1;
+    if (id >= 0) start = std::chrono::steady_clock::now();
+  }
+
+  ~StageTimer() {
+    if (id >= 0) {
+      StageProfiler::record(id, std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    }
+  }
+
+private:
+  int id;
+  std::chrono::steady_clock::time_point start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+/** Times the rest of the enclosing scope as the stage `name`. */
+#define PROFILE_STAGE(name) \
+  static const int PROFILE_CONCAT(_profile_id_, __LINE__) = \
+    StageProfiler::stage(name); \
+  StageTimer PROFILE_CONCAT(_profile_timer_, __LINE__)( \
+    PROFILE_CONCAT(_profile_id_, __LINE__))
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef _RLTELEMETRY_H_
+#define _RLTELEMETRY_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <initializer_list>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TELEMETRY_MAGIC "RLTL"
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_MAX_VALUES 16
+// Records the ring can hold, a power of 2
+#define TELEMETRY_CAPACITY (1 << 14)
+
+/** Binary log of the samples an env records every step, eg. its trajectory.
+    The control thread copies a record into a preallocated ring and moves
+    on; a writer thread of the log takes them out and writes them to the
+    file. Neither side takes a lock, and the control thread never waits for
+    the disk: if the writer falls a whole ring behind, records are dropped
+    and counted.
+
+    A log has a few channels, named after the text files they replace, eg.
+    quadrotor_trajectory.txt. The file is a header (TELEMETRY_MAGIC,
+    TELEMETRY_VERSION, the number of channels and their names, each as a
+    uint32 length and the bytes) followed by the records: a uint8 channel,
+    a uint8 count and that many floats, in the byte order of the machine.
+    telemetry_to_text writes the channels back out as those text files.
+
+    Only one thread may call log(). */
+class TelemetryLog {
+public:
+  /** \param file_name Of the log, truncated.
+      \param channels Names of the channels, the ids of log() index it. */
+  TelemetryLog(const std::string &file_name,
+               const std::vector<std::string> &channels);
+
+  /** Writes what is still in the ring, and closes the file. */
+  ~TelemetryLog();
+
+  /** Queues a record of up to TELEMETRY_MAX_VALUES values.
+      \return Whether it was queued; false when the ring is full. */
+  bool log(int channel, const float* values, int n);
+  bool log(int channel, std::initializer_list<float> values) {
+    return log(channel, values.begin(), values.size());
+  }
+
+  bool good() const { return file != NULL; }
+  long dropped() const { return dropped_records.load(); }
+
+private:
+  struct Record {
+    uint8_t channel, n;
+    float values[TELEMETRY_MAX_VALUES];
+  };
+
+  std::string file_name;
+  FILE* file;
+  std::vector<Record> ring;
+
+  // head is only written by log(), tail only by the writer. They are kept
+  // a cache line apart, so that the two threads do not share one.
+  std::atomic<size_t> head;
+  char head_padding[64];
+  std::atomic<size_t> tail;
+  char tail_padding[64];
+  std::atomic<bool> running;
+  std::atomic<long> dropped_records;
+  std::thread writer;
+
+  void write_loop();
+  size_t write_records(); // Returns how many
+};
+
+/** Reads the records of a TelemetryLog file back, one at a time. */
+class TelemetryReader {
+public:
+  TelemetryReader(const std::string &file_name);
+  ~TelemetryReader();
+
+  /** Whether the file is a telemetry log, and the header was read. */
+  bool good() const { return file != NULL; }
+  const std::vector<std::string> &channels() const { return channel_names; }
+
+  /** \return false at the end of the file, or at a record cut short. */
+  bool next(int &channel, std::vector<float> &values);
+
+private:
+  FILE* file;
+  std::vector<std::string> channel_names;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef _RLVECENV_H_
+#define _RLVECENV_H_
+
+#include <rl_common/core.hh>
+
+/** Steps N environments as one batch. Actions are given as one row-major
+    N x n_action array and the results of a step are written into one
+    contiguous buffer laid out as
+      [ states (N x n_state) | rewards (N) | terminals (N) ]
+    so that batched agents can consume them without any per-slot copies.
+
+    When the episode in a slot ends, that slot is reset automatically. Its
+    terminal flag is set for that step, the reward is the last reward of the
+    finished episode, and its state row already holds the initial sensation
+    of the next episode. */
+class VecEnvironment {
+public:
+  /** \param envs The environments, one per slot. They are owned (and
+      deleted) by the VecEnvironment.
+      \param n_state Size of the sensation vector of each environment.
+      \param n_action Size of the action vector of each environment. */
+  VecEnvironment(const std::vector<Environment*> &envs,
+                 int n_state, int n_action);
+
+  virtual ~VecEnvironment();
+
+  /** Resets all slots.
+      \return The states block of the buffer. */
+  virtual const float* reset();
+
+  /** Applies one action per slot and steps all the slots.
+      \param actions Row-major array of size() x action_size() floats.
+      \return The states block of the buffer. */
+  virtual const float* step(const float* actions);
+
+  /** Starts a new episode in one slot, eg. when it is stopped before the
+      env ends it. The rows of the other slots are left as they are. */
+  virtual void reset_slot(int slot);
+
+  int size() const { return n_envs; }
+  int state_size() const { return n_state; }
+  int action_size() const { return n_action; }
+
+  const float* states() const { return &buffer[0]; }
+  const float* rewards() const { return &buffer[n_envs * n_state]; }
+  /** 1.0 for slots whose episode ended on the last step, 0.0 otherwise. */
+  const float* terminals() const { return &buffer[n_envs * (n_state + 1)]; }
+
+  /** Number of steps taken in the current episode of a slot. */
+  long episode_steps(int slot) const { return steps[slot]; }
+  Environment* get(int slot) { return envs[slot]; }
+
+protected:
+  int n_envs, n_state, n_action;
+  std::vector<Environment*> envs;
+  std::vector<float> buffer;
+  std::vector<long> steps;
+  std::vector<float> action; // Scratch vector for Environment::apply
+
+  // Applies the action and writes the result of one slot into the buffer
+  void step_slot(int slot, const float* slot_action);
+  void write_state(int slot, const std::vector<float> &s);
+};
+
+/** Drives single-environment agents against a VecEnvironment, with one
+    Agent per slot. Each agent sees exactly the sequence of calls that it
+    would get from the rl_agent node: first_action at the start of an
+    episode, next_action on every step and last_action when it ends. */
+class VecAgentAdapter {
+public:
+  /** \param agents One agent per slot of the VecEnvironment. They are not
+      owned by the adapter. */
+  VecAgentAdapter(const std::vector<Agent*> &agents, int n_action);
+
+  /** Computes the actions for the first step after VecEnvironment::reset.
+      \return Row-major array of actions, valid until the next call. */
+  const float* first_actions(const VecEnvironment &env);
+
+  /** Gives the feedback of the last step to the agents and computes the
+      actions for the next step.
+      \return Row-major array of actions, valid until the next call. */
+  const float* next_actions(const VecEnvironment &env);
+
+  /** Gives the last reward to the agents whose episode ended in the last
+      step, without starting their next one. For when the run stops after
+      that step. */
+  void last_actions(const VecEnvironment &env);
+
+protected:
+  int n_action;
+  std::vector<Agent*> agents;
+  std::vector<float> actions;
+  std::vector<float> state; // Scratch vector for the Agent interface
+
+  void set_action(int slot, const std::vector<float> &a);
+};
+
+#endif
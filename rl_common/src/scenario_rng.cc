@@ -0,0 +1,44 @@
+#include <rl_common/scenario_rng.hh>
+
+#include <cmath>
+
+namespace {
+
+// Finalizer of splitmix64. Consecutive inputs give independent looking
+// outputs, which is what makes the generator counter based.
+inline uint64_t mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+const uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+}
+
+ScenarioRng::ScenarioRng(uint64_t seed_, uint64_t scenario_, uint64_t stream_) {
+  seed = seed_;
+  stream = stream_;
+  set_scenario(scenario_);
+}
+
+void ScenarioRng::set_scenario(uint64_t scenario_) {
+  scenario = scenario_;
+  key = stream_key(seed, scenario, stream);
+  counter = 0;
+}
+
+uint64_t ScenarioRng::stream_key(uint64_t seed, uint64_t scenario,
+                                 uint64_t stream) {
+  return mix(mix(mix(seed) + scenario * GOLDEN_GAMMA) + stream * GOLDEN_GAMMA);
+}
+
+double ScenarioRng::normal() {
+  double u1 = 1.0 - uniform(); // In (0, 1]
+  double u2 = uniform();
+  return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+uint64_t ScenarioRng::at(uint64_t key, uint64_t n) {
+  return mix(key + (n + 1) * GOLDEN_GAMMA);
+}
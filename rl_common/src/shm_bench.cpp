@@ -0,0 +1,179 @@
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+
+#include <rl_common/core.hh>
+#include <rl_common/shm_transport.hh>
+
+// Messages
+#include <rl_common/RLStateReward.h>
+#include <rl_common/RLAction.h>
+
+#include <getopt.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Microbenchmark of one agent <-> env round trip: a state/reward goes one
+// way and an action comes back, with no work done on either side. Compares
+// the rl_env/rl_state_reward + rl_agent/rl_action topics (tcpNoDelay, queue
+// depth 1, as used by the nodes) against ShmTransport. The peer is a forked
+// process in both cases, as the real agent is.
+
+#define BENCH_SHM_NAME "/rl_step_transport_bench"
+#define EPISODE_STEPS 10000
+
+int round_trips = 10000;
+int warmup = 1000;
+
+void report(const std::string &name, std::vector<double> &latencies) {
+  std::sort(latencies.begin(), latencies.end());
+  double total = 0;
+  for (size_t i = 0; i < latencies.size(); ++i) total += latencies[i];
+  double mean = total / latencies.size();
+
+  std::cout << name << ": " << latencies.size() << " round trips, latency (us)"
+            << " mean " << 1e6 * mean
+            << " p50 " << 1e6 * latencies[latencies.size() / 2]
+            << " p99 " << 1e6 * latencies[latencies.size() * 99 / 100]
+            << " max " << 1e6 * latencies.back()
+            << "\n  => " << mean * EPISODE_STEPS
+            << " sec of transport per " << EPISODE_STEPS << " step episode\n";
+}
+
+// ------------------------------- ROS ---------------------------------------
+
+ros::Publisher pub;
+bool got_reply;
+
+void echo_state(const rl_common::RLStateReward::ConstPtr &state_in) {
+  rl_common::RLAction msg;
+  msg.action.resize(SHM_ACTION_SIZE, state_in->reward);
+  pub.publish(msg);
+}
+
+void receive_action(const rl_common::RLAction::ConstPtr &action_in) {
+  got_reply = true;
+}
+
+void bench_ros(int argc, char *argv[]) {
+  pid_t child = fork();
+  ros::TransportHints no_delay = ros::TransportHints().tcpNoDelay(true);
+
+  if (child == 0) {
+    ros::init(argc, argv, "ShmBenchEcho");
+    ros::NodeHandle node;
+    pub = node.advertise<rl_common::RLAction>("shm_bench/rl_action", 1, false);
+    ros::Subscriber sub = node.subscribe("shm_bench/rl_state_reward", 1,
+                                         echo_state, no_delay);
+    ros::spin();
+    exit(0);
+  }
+
+  ros::init(argc, argv, "ShmBench");
+  ros::NodeHandle node;
+  pub = node.advertise<rl_common::RLStateReward>("shm_bench/rl_state_reward",
+                                                 1, false);
+  ros::Subscriber sub = node.subscribe("shm_bench/rl_action", 1,
+                                       receive_action, no_delay);
+
+  // Wait for both directions to be connected
+  while (ros::ok() && (pub.getNumSubscribers() == 0 ||
+                       sub.getNumPublishers() == 0)) {
+    ros::WallDuration(0.1).sleep();
+  }
+
+  rl_common::RLStateReward sr;
+  sr.state.resize(SHM_STATE_SIZE, 1.0);
+  sr.terminal = false;
+
+  std::vector<double> latencies;
+  for (int i = 0; i < warmup + round_trips && ros::ok(); ++i) {
+    ros::WallTime start = ros::WallTime::now();
+    got_reply = false;
+    sr.reward = i;
+    pub.publish(sr);
+    while (!got_reply && ros::ok()) {
+      ros::getGlobalCallbackQueue()->callAvailable(ros::WallDuration(0.1));
+    }
+    if (i >= warmup) {
+      latencies.push_back((ros::WallTime::now() - start).toSec());
+    }
+  }
+
+  kill(child, SIGINT);
+  waitpid(child, NULL, 0);
+  report("ros topics", latencies);
+}
+
+// --------------------------- SHARED MEMORY ---------------------------------
+
+void bench_shm() {
+  pid_t child = fork();
+
+  if (child == 0) {
+    ShmTransport shm(BENCH_SHM_NAME, ShmTransport::AGENT);
+    ShmStepRecord record;
+    for (int i = 0; i < warmup + round_trips; ++i) {
+      shm.receive(record);
+      record.kind = ShmStepRecord::ACTION;
+      std::fill(record.action, record.action + SHM_ACTION_SIZE, record.reward);
+      shm.send(record);
+    }
+    exit(0);
+  }
+
+  ShmTransport shm(BENCH_SHM_NAME, ShmTransport::ENV);
+  ShmStepRecord record;
+  record.kind = ShmStepRecord::STATE;
+  record.terminal = false;
+  std::fill(record.state, record.state + SHM_STATE_SIZE, 1.0);
+
+  std::vector<double> latencies;
+  for (int i = 0; i < warmup + round_trips; ++i) {
+    ros::WallTime start = ros::WallTime::now();
+    record.reward = i;
+    shm.send(record);
+    shm.receive(record);
+    if (i >= warmup) {
+      latencies.push_back((ros::WallTime::now() - start).toSec());
+    }
+  }
+
+  waitpid(child, NULL, 0);
+  report("shared memory", latencies);
+}
+
+int main(int argc, char *argv[]) {
+  char ch;
+  const char* optflags = "nm";
+  int option_index = 0;
+  std::string mode = "all";
+  static struct option long_options[] = {
+    {"n", 1, 0, 'n'},
+    {"mode", 1, 0, 'm'},
+    {NULL, 0, 0, 0}
+  };
+
+  while(-1 != (ch = getopt_long_only(argc, argv, optflags, long_options, &option_index))) {
+    switch(ch) {
+    case 'n':
+      round_trips = std::max(1, std::atoi(optarg));
+      break;
+    case 'm':
+      mode = optarg;
+      break;
+    default:
+      std::cout << "\n shm_bench [--n round_trips] [--mode all|shm|ros]\n";
+      exit(-1);
+    }
+  }
+
+  if (mode == "all" || mode == "shm") {
+    bench_shm();
+  }
+  if (mode == "all" || mode == "ros") {
+    bench_ros(argc, argv);
+  }
+  return 0;
+}
@@ -0,0 +1,164 @@
+#include <rl_common/shm_transport.hh>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHM_MAGIC 0x524c5354 // "RLST"
+#define SHM_VERSION 2
+
+// Number of times to poll before going to sleep on the futex. A step of the
+// peer normally finishes well within this, so the futex is only hit when
+// the peer is really idle (eg. between episodes).
+#define SHM_SPIN_COUNT 20000
+
+static int futex(std::atomic<uint32_t> *addr, int op, uint32_t val,
+                 const struct timespec *timeout) {
+  return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), op, val,
+                 timeout, NULL, 0);
+}
+
+ShmTransport::ShmTransport(const std::string &n, Role r) {
+  name = n;
+  role = r;
+
+  if (role == AGENT) {
+    std::cout << "ShmTransport: Waiting for " << name << " ...\n";
+    while ((segment = attach()) == NULL) {
+      usleep(100000);
+    }
+    in = &segment->to_agent;
+    out = &segment->to_env;
+    std::cout << "ShmTransport: Attached to " << name << "\n";
+    return;
+  }
+
+  // A segment left behind by a crashed env is replaced by a new one, rather
+  // than reset under an agent that may have attached to it
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0 || ftruncate(fd, sizeof(Segment)) != 0) {
+    throw std::runtime_error("ShmTransport: cannot create " + name + ": " +
+                             strerror(errno));
+  }
+  void* mem = mmap(NULL, sizeof(Segment), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) {
+    throw std::runtime_error("ShmTransport: cannot map " + name + ": " +
+                             strerror(errno));
+  }
+  segment = static_cast<Segment*>(mem);
+
+  // A new object is zero filled: the rings are empty
+  segment->version = SHM_VERSION;
+  segment->owner = getpid();
+  __atomic_store_n(&segment->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+  in = &segment->to_env;
+  out = &segment->to_agent;
+  std::cout << "ShmTransport: Attached to " << name << "\n";
+}
+
+ShmTransport::Segment* ShmTransport::attach() {
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Segment)) {
+    close(fd);
+    return NULL;
+  }
+  void* mem = mmap(NULL, sizeof(Segment), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) {
+    return NULL;
+  }
+
+  // Not set up yet, or of an env that is gone. Opened again by name on the
+  // next try, so the segment of the env that replaces it is found.
+  Segment* s = static_cast<Segment*>(mem);
+  if (__atomic_load_n(&s->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC ||
+      (kill(s->owner, 0) != 0 && errno == ESRCH)) {
+    munmap(mem, sizeof(Segment));
+    return NULL;
+  }
+  assert(s->version == SHM_VERSION);
+  return s;
+}
+
+ShmTransport::~ShmTransport() {
+  munmap(segment, sizeof(Segment));
+  if (role == ENV) {
+    shm_unlink(name.c_str());
+  }
+}
+
+void ShmTransport::send(const ShmStepRecord &record) {
+  uint32_t head = out->head.load(std::memory_order_relaxed);
+
+  // Wait for space. With one outstanding record per side this never spins.
+  while (head - out->tail.load(std::memory_order_acquire) >= SHM_RING_SIZE) {
+    sched_yield();
+  }
+
+  out->records[head & (SHM_RING_SIZE - 1)] = record;
+  out->head.store(head + 1, std::memory_order_release);
+
+  if (out->waiting.load(std::memory_order_seq_cst)) {
+    futex(&out->head, FUTEX_WAKE, 1, NULL);
+  }
+}
+
+bool ShmTransport::receive(ShmStepRecord &record, int timeout_ms) {
+  uint32_t tail = in->tail.load(std::memory_order_relaxed);
+
+  for (int spin = 0; in->head.load(std::memory_order_acquire) == tail; ++spin) {
+    if (spin < SHM_SPIN_COUNT) continue;
+
+    // Nothing came in while spinning, sleep until the producer wakes us.
+    // `waiting` is set before checking head again, so that a send in
+    // between either sees it or is seen by us.
+    in->waiting.store(1, std::memory_order_seq_cst);
+    if (in->head.load(std::memory_order_seq_cst) == tail) {
+      struct timespec ts;
+      ts.tv_sec = timeout_ms / 1000;
+      ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+      int res = futex(&in->head, FUTEX_WAIT, tail, timeout_ms < 0 ? NULL : &ts);
+      if (res != 0 && errno == ETIMEDOUT) {
+        in->waiting.store(0, std::memory_order_relaxed);
+        return false;
+      }
+    }
+    in->waiting.store(0, std::memory_order_relaxed);
+    spin = 0;
+  }
+
+  record = in->records[tail & (SHM_RING_SIZE - 1)];
+  in->tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+void ShmTransport::set_state(ShmStepRecord &record, const std::vector<float> &s) {
+  assert(s.size() == SHM_STATE_SIZE);
+  std::copy(s.begin(), s.end(), record.state);
+}
+
+void ShmTransport::set_action(ShmStepRecord &record, const std::vector<float> &a) {
+  assert(a.size() == SHM_ACTION_SIZE);
+  std::copy(a.begin(), a.end(), record.action);
+}
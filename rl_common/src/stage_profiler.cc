@@ -0,0 +1,207 @@
+#include <rl_common/stage_profiler.hh>
+
+#include <iomanip>
+#include <mutex>
+#include <thread>
+
+#include <ros/ros.h>
+#include <rl_common/RLStageLatency.h>
+
+std::atomic<bool> StageProfiler::enabled_flag(false);
+
+namespace {
+
+// Histogram of one stage, only written by the thread that owns it
+struct Histogram {
+  std::atomic<uint64_t> buckets[PROFILER_BUCKETS];
+  std::atomic<uint64_t> count, total, max;
+
+  Histogram() : count(0), total(0), max(0) {
+    for (int i = 0; i < PROFILER_BUCKETS; ++i) buckets[i] = 0;
+  }
+};
+
+// Single writer, so there is no need for a read-modify-write
+inline void add(std::atomic<uint64_t> &counter, uint64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
+
+// The histograms of one thread. Created on the first record of each stage.
+struct ThreadHistograms {
+  std::atomic<Histogram*> stages[PROFILER_MAX_STAGES];
+
+  ThreadHistograms() {
+    for (int i = 0; i < PROFILER_MAX_STAGES; ++i) stages[i] = NULL;
+  }
+};
+
+std::mutex registry_mutex;
+std::vector<std::string> stage_names;
+// Kept after their thread exits, so that dump() at shutdown sees everything
+std::vector<ThreadHistograms*> threads;
+
+thread_local ThreadHistograms* local = NULL;
+
+std::thread publisher;
+std::atomic<bool> publishing(false);
+
+} // namespace
+
+int StageProfiler::bucket(uint64_t value) {
+  if (value < PROFILER_SUB_BUCKETS) return value;
+
+  int msb = 63 - __builtin_clzll(value);
+  int shift = msb - PROFILER_SUB_BITS; // value >> shift is in [SUB, 2*SUB)
+  int b = shift * PROFILER_SUB_BUCKETS + (value >> shift);
+  return std::min(b, PROFILER_BUCKETS - 1);
+}
+
+uint64_t StageProfiler::bucket_value(int b) {
+  if (b < 2 * PROFILER_SUB_BUCKETS) return b;
+
+  int shift = b / PROFILER_SUB_BUCKETS - 1;
+  uint64_t sub = b - shift * PROFILER_SUB_BUCKETS;
+  // Middle of the bucket
+  return (sub << shift) + ((1ULL << shift) >> 1);
+}
+
+int StageProfiler::stage(const std::string &name) {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (size_t i = 0; i < stage_names.size(); ++i) {
+    if (stage_names[i] == name) return i;
+  }
+  if (stage_names.size() == PROFILER_MAX_STAGES) {
+    std::cerr << "StageProfiler: Too many stages, not profiling " << name << "\n";
+    return -1;
+  }
+  stage_names.push_back(name);
+  return stage_names.size() - 1;
+}
+
+void StageProfiler::record(int stage_id, uint64_t ns) {
+  if (stage_id < 0) return;
+
+  if (local == NULL) {
+    local = new ThreadHistograms();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    threads.push_back(local);
+  }
+
+  Histogram* h = local->stages[stage_id].load(std::memory_order_relaxed);
+  if (h == NULL) {
+    h = new Histogram();
+    local->stages[stage_id].store(h, std::memory_order_release);
+  }
+
+  add(h->buckets[bucket(ns)], 1);
+  add(h->count, 1);
+  add(h->total, ns);
+  if (ns > h->max.load(std::memory_order_relaxed)) {
+    h->max.store(ns, std::memory_order_relaxed);
+  }
+}
+
+std::vector<StageProfiler::Summary> StageProfiler::summaries() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  std::vector<Summary> result;
+  std::vector<uint64_t> merged(PROFILER_BUCKETS);
+
+  for (size_t s = 0; s < stage_names.size(); ++s) {
+    Summary summary;
+    summary.stage = stage_names[s];
+    summary.count = 0;
+    summary.max = 0;
+    uint64_t total = 0, max = 0;
+    std::fill(merged.begin(), merged.end(), 0);
+
+    for (size_t t = 0; t < threads.size(); ++t) {
+      Histogram* h = threads[t]->stages[s].load(std::memory_order_acquire);
+      if (h == NULL) continue;
+      for (int b = 0; b < PROFILER_BUCKETS; ++b) {
+        merged[b] += h->buckets[b].load(std::memory_order_relaxed);
+      }
+      summary.count += h->count.load(std::memory_order_relaxed);
+      total += h->total.load(std::memory_order_relaxed);
+      max = std::max(max, h->max.load(std::memory_order_relaxed));
+    }
+    if (summary.count == 0) continue;
+
+    // Percentiles from the merged buckets
+    double* percentiles[] = {&summary.p50, &summary.p90, &summary.p99};
+    double fractions[] = {0.5, 0.9, 0.99};
+    uint64_t seen = 0;
+    int p = 0;
+    for (int b = 0; b < PROFILER_BUCKETS && p < 3; ++b) {
+      seen += merged[b];
+      while (p < 3 && seen >= fractions[p] * summary.count) {
+        *percentiles[p] = bucket_value(b) / 1000.0;
+        p += 1;
+      }
+    }
+
+    summary.mean = total / 1000.0 / summary.count;
+    summary.max = max / 1000.0;
+    result.push_back(summary);
+  }
+  return result;
+}
+
+void StageProfiler::dump(std::ostream &out) {
+  std::vector<Summary> all = summaries();
+  if (all.empty()) return;
+
+  out << "Stage latencies (us):\n"
+      << std::left << std::setw(28) << "stage" << std::right
+      << std::setw(10) << "count" << std::setw(10) << "mean"
+      << std::setw(10) << "p50" << std::setw(10) << "p90"
+      << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+  for (size_t i = 0; i < all.size(); ++i) {
+    out << std::left << std::setw(28) << all[i].stage << std::right
+        << std::fixed << std::setprecision(1)
+        << std::setw(10) << all[i].count << std::setw(10) << all[i].mean
+        << std::setw(10) << all[i].p50 << std::setw(10) << all[i].p90
+        << std::setw(10) << all[i].p99 << std::setw(10) << all[i].max << "\n";
+  }
+  out.unsetf(std::ios_base::floatfield);
+}
+
+static void publish_loop(std::string topic, double period) {
+  ros::NodeHandle node;
+  ros::Publisher pub = node.advertise<rl_common::RLStageLatency>(topic, 1, true);
+
+  ros::WallTime next = ros::WallTime::now() + ros::WallDuration(period);
+  while (publishing && ros::ok()) {
+    if (ros::WallTime::now() < next) {
+      ros::WallDuration(0.05).sleep();
+      continue;
+    }
+    next = next + ros::WallDuration(period);
+
+    std::vector<StageProfiler::Summary> all = StageProfiler::summaries();
+    rl_common::RLStageLatency msg;
+    for (size_t i = 0; i < all.size(); ++i) {
+      msg.stage.push_back(all[i].stage);
+      msg.count.push_back(all[i].count);
+      msg.mean.push_back(all[i].mean);
+      msg.p50.push_back(all[i].p50);
+      msg.p90.push_back(all[i].p90);
+      msg.p99.push_back(all[i].p99);
+      msg.max.push_back(all[i].max);
+    }
+    pub.publish(msg);
+  }
+}
+
+void StageProfiler::start_publishing(const std::string &topic, double period) {
+  if (publishing) return;
+  publishing = true;
+  publisher = std::thread(publish_loop, topic, period);
+}
+
+void StageProfiler::stop_publishing() {
+  publishing = false;
+  if (publisher.joinable()) {
+    publisher.join();
+  }
+}
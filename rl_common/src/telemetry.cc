@@ -0,0 +1,145 @@
+#include <rl_common/telemetry.hh>
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// How long the writer sleeps when the ring is empty
+#define TELEMETRY_IDLE_MS 1
+
+TelemetryLog::TelemetryLog(const std::string &name,
+                           const std::vector<std::string> &channels)
+  : file_name(name), ring(TELEMETRY_CAPACITY), head(0), tail(0),
+    running(true), dropped_records(0) {
+  file = fopen(file_name.c_str(), "wb");
+  if (file == NULL) {
+    std::cerr << "TelemetryLog: Cannot write " << file_name << "\n";
+    return;
+  }
+  setvbuf(file, NULL, _IOFBF, 1 << 16);
+
+  uint32_t version = TELEMETRY_VERSION, n_channels = channels.size();
+  fwrite(TELEMETRY_MAGIC, 1, 4, file);
+  fwrite(&version, sizeof(version), 1, file);
+  fwrite(&n_channels, sizeof(n_channels), 1, file);
+  for (size_t i = 0; i < channels.size(); ++i) {
+    uint32_t length = channels[i].size();
+    fwrite(&length, sizeof(length), 1, file);
+    fwrite(channels[i].data(), 1, length, file);
+  }
+  fflush(file);
+
+  writer = std::thread(&TelemetryLog::write_loop, this);
+}
+
+TelemetryLog::~TelemetryLog() {
+  if (file == NULL) {
+    return;
+  }
+  running = false;
+  writer.join();
+  fclose(file);
+  if (dropped_records > 0) {
+    std::cerr << "TelemetryLog: " << dropped_records << " records of "
+              << file_name << " were dropped, the writer fell behind\n";
+  }
+}
+
+bool TelemetryLog::log(int channel, const float* values, int n) {
+  if (file == NULL) {
+    return false;
+  }
+  size_t h = head.load(std::memory_order_relaxed);
+  if (h - tail.load(std::memory_order_acquire) == ring.size()) {
+    dropped_records.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  Record &record = ring[h & (ring.size() - 1)];
+  record.channel = channel;
+  record.n = std::min(n, TELEMETRY_MAX_VALUES);
+  memcpy(record.values, values, record.n * sizeof(float));
+  head.store(h + 1, std::memory_order_release);
+  return true;
+}
+
+size_t TelemetryLog::write_records() {
+  size_t t = tail.load(std::memory_order_relaxed);
+  size_t h = head.load(std::memory_order_acquire);
+  for (size_t i = t; i != h; ++i) {
+    const Record &record = ring[i & (ring.size() - 1)];
+    fwrite(&record.channel, 1, 1, file);
+    fwrite(&record.n, 1, 1, file);
+    fwrite(record.values, sizeof(float), record.n, file);
+  }
+  // The slots can be reused once they are copied to the file's buffer
+  tail.store(h, std::memory_order_release);
+  return h - t;
+}
+
+void TelemetryLog::write_loop() {
+  while (running.load()) {
+    if (write_records() == 0) {
+      // Idle: let the records written so far reach the file
+      fflush(file);
+      std::this_thread::sleep_for(std::chrono::milliseconds(TELEMETRY_IDLE_MS));
+    }
+  }
+  // log() is not called anymore, the ring is drained once more
+  write_records();
+  fflush(file);
+}
+
+TelemetryReader::TelemetryReader(const std::string &file_name) {
+  file = fopen(file_name.c_str(), "rb");
+  if (file == NULL) {
+    std::cerr << "TelemetryReader: Cannot read " << file_name << "\n";
+    return;
+  }
+
+  char magic[4];
+  uint32_t version = 0, n_channels = 0;
+  bool ok = fread(magic, 1, 4, file) == 4 &&
+            memcmp(magic, TELEMETRY_MAGIC, 4) == 0 &&
+            fread(&version, sizeof(version), 1, file) == 1 &&
+            version == TELEMETRY_VERSION &&
+            fread(&n_channels, sizeof(n_channels), 1, file) == 1 &&
+            n_channels <= 256;
+  for (uint32_t i = 0; ok && i < n_channels; ++i) {
+    uint32_t length = 0;
+    ok = fread(&length, sizeof(length), 1, file) == 1 && length < 4096;
+    if (ok) {
+      std::string name(length, ' ');
+      ok = fread(&name[0], 1, length, file) == length;
+      channel_names.push_back(name);
+    }
+  }
+
+  if (!ok) {
+    std::cerr << "TelemetryReader: " << file_name << " is not a telemetry log\n";
+    fclose(file);
+    file = NULL;
+    channel_names.clear();
+  }
+}
+
+TelemetryReader::~TelemetryReader() {
+  if (file != NULL) {
+    fclose(file);
+  }
+}
+
+bool TelemetryReader::next(int &channel, std::vector<float> &values) {
+  if (file == NULL) {
+    return false;
+  }
+  uint8_t header[2];
+  if (fread(header, 1, 2, file) != 2 || header[1] > TELEMETRY_MAX_VALUES) {
+    return false;
+  }
+  channel = header[0];
+  values.resize(header[1]);
+  return header[1] == 0 ||
+         fread(&values[0], sizeof(float), header[1], file) == header[1];
+}
@@ -0,0 +1,103 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <rl_common/telemetry.hh>
+
+#include <getopt.h>
+#include <stdlib.h>
+
+// Writes the channels of TelemetryLog files back out as the text files they
+// are named after, eg. quadrotor_trajectory.txt with one sample per line and
+// the values separated by spaces, as the envs used to write them. Those are
+// what trajectory_compare and the apprenticeship scripts read.
+
+void display_help() {
+  std::cout << "\n telemetry_to_text --log file [--log file ...] [options]\n";
+  std::cout << "\n Options:\n";
+  std::cout << "--log file (Binary log of an env, eg. quadrotor_log.bin)\n";
+  std::cout << "--dir path (Where to write the text files. Default: .)\n";
+  exit(-1);
+}
+
+int convert(const std::string &log_file, const std::string &dir) {
+  TelemetryReader reader(log_file);
+  if (!reader.good()) {
+    return -1;
+  }
+
+  const std::vector<std::string> &channels = reader.channels();
+  std::vector<std::ofstream*> files(channels.size());
+  std::vector<long> lines(channels.size(), 0);
+  for (size_t c = 0; c < channels.size(); ++c) {
+    std::string name = dir + "/" + channels[c];
+    files[c] = new std::ofstream(name.c_str(), std::ios::trunc);
+    if (!files[c]->good()) {
+      std::cerr << "Cannot write " << name << "\n";
+    }
+  }
+
+  int channel;
+  std::vector<float> values;
+  while (reader.next(channel, values)) {
+    if (channel >= (int)channels.size()) {
+      continue;
+    }
+    std::ofstream &out = *files[channel];
+    for (size_t i = 0; i < values.size(); ++i) {
+      out << (i > 0 ? " " : "") << values[i];
+    }
+    out << "\n";
+    lines[channel] += 1;
+  }
+
+  for (size_t c = 0; c < channels.size(); ++c) {
+    std::cout << log_file << ": " << lines[c] << " lines to "
+              << dir << "/" << channels[c] << "\n";
+    delete files[c];
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> logs;
+  std::string dir = ".";
+
+  char ch;
+  const char* optflags = "ld";
+  int option_index = 0;
+  static struct option long_options[] = {
+    {"log", 1, 0, 'l'},
+    {"dir", 1, 0, 'd'},
+    {NULL, 0, 0, 0}
+  };
+
+  while(-1 != (ch = getopt_long_only(argc, argv, optflags, long_options, &option_index))) {
+    switch(ch) {
+    case 'l':
+      logs.push_back(optarg);
+      break;
+
+    case 'd':
+      dir = optarg;
+      break;
+
+    default:
+      display_help();
+      break;
+    }
+  }
+
+  if (logs.empty()) {
+    display_help();
+  }
+
+  int result = 0;
+  for (size_t i = 0; i < logs.size(); ++i) {
+    if (convert(logs[i], dir) != 0) {
+      result = -1;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,128 @@
+#include <cassert>
+
+#include <rl_common/vec_env.hh>
+
+VecEnvironment::VecEnvironment(const std::vector<Environment*> &e,
+                               int ns, int na) {
+  envs = e;
+  n_envs = envs.size();
+  n_state = ns;
+  n_action = na;
+
+  buffer.resize(n_envs * (n_state + 2), 0);
+  steps.resize(n_envs, 0);
+  action.resize(n_action);
+}
+
+VecEnvironment::~VecEnvironment() {
+  for (int i = 0; i < n_envs; ++i) {
+    delete envs[i];
+  }
+}
+
+const float* VecEnvironment::reset() {
+  for (int i = 0; i < n_envs; ++i) {
+    envs[i]->reset();
+    write_state(i, envs[i]->sensation());
+    buffer[n_envs * n_state + i] = 0;
+    buffer[n_envs * (n_state + 1) + i] = 0;
+    steps[i] = 0;
+  }
+  return states();
+}
+
+const float* VecEnvironment::step(const float* actions) {
+  for (int i = 0; i < n_envs; ++i) {
+    step_slot(i, actions + i * n_action);
+  }
+  return states();
+}
+
+void VecEnvironment::reset_slot(int slot) {
+  envs[slot]->reset();
+  write_state(slot, envs[slot]->sensation());
+  buffer[n_envs * n_state + slot] = 0;
+  buffer[n_envs * (n_state + 1) + slot] = 0;
+  steps[slot] = 0;
+}
+
+void VecEnvironment::step_slot(int slot, const float* slot_action) {
+  Environment* env = envs[slot];
+
+  std::copy(slot_action, slot_action + n_action, action.begin());
+  float r = env->apply(action);
+  const std::vector<float> &s = env->sensation();
+  bool t = env->terminal();
+  steps[slot] += 1;
+
+  buffer[n_envs * n_state + slot] = r;
+  buffer[n_envs * (n_state + 1) + slot] = t ? 1 : 0;
+
+  if (t) {
+    // Start the next episode right away, the same as the env node does
+    // when it gets the end of episode message.
+    env->reset();
+    write_state(slot, env->sensation());
+    steps[slot] = 0;
+  } else {
+    write_state(slot, s);
+  }
+}
+
+void VecEnvironment::write_state(int slot, const std::vector<float> &s) {
+  assert((int)s.size() == n_state);
+  std::copy(s.begin(), s.end(), buffer.begin() + slot * n_state);
+}
+
+// --------------- ADAPTER ----------------------------
+
+VecAgentAdapter::VecAgentAdapter(const std::vector<Agent*> &a, int na) {
+  agents = a;
+  n_action = na;
+  actions.resize(agents.size() * n_action);
+}
+
+const float* VecAgentAdapter::first_actions(const VecEnvironment &env) {
+  assert(env.size() == (int)agents.size());
+  int n_state = env.state_size();
+
+  for (int i = 0; i < env.size(); ++i) {
+    const float* s = env.states() + i * n_state;
+    state.assign(s, s + n_state);
+    set_action(i, agents[i]->first_action(state));
+  }
+  return &actions[0];
+}
+
+const float* VecAgentAdapter::next_actions(const VecEnvironment &env) {
+  assert(env.size() == (int)agents.size());
+  int n_state = env.state_size();
+
+  for (int i = 0; i < env.size(); ++i) {
+    const float* s = env.states() + i * n_state;
+    state.assign(s, s + n_state);
+
+    if (env.terminals()[i]) {
+      // The state row already belongs to the next episode
+      agents[i]->last_action(env.rewards()[i]);
+      set_action(i, agents[i]->first_action(state));
+    } else {
+      set_action(i, agents[i]->next_action(env.rewards()[i], state));
+    }
+  }
+  return &actions[0];
+}
+
+void VecAgentAdapter::last_actions(const VecEnvironment &env) {
+  assert(env.size() == (int)agents.size());
+  for (int i = 0; i < env.size(); ++i) {
+    if (env.terminals()[i]) {
+      agents[i]->last_action(env.rewards()[i]);
+    }
+  }
+}
+
+void VecAgentAdapter::set_action(int slot, const std::vector<float> &a) {
+  assert((int)a.size() == n_action);
+  std::copy(a.begin(), a.end(), actions.begin() + slot * n_action);
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+#include <rl_common/telemetry.hh>
+
+static const std::vector<std::string> channels = {
+  "quadrotor_trajectory.txt", "quadrotor_data.txt"
+};
+
+// A log in /tmp named after the running test
+static std::string log_name() {
+  std::stringstream name;
+  name << "/tmp/" << testing::UnitTest::GetInstance()->current_test_info()->name()
+       << "_" << getpid() << ".bin";
+  return name.str();
+}
+
+TEST(Telemetry, RecordsAreReadBackInOrder) {
+  std::string file_name = log_name();
+  // Fewer than the ring holds, so none can be dropped
+  const int n = TELEMETRY_CAPACITY / 2;
+  {
+    TelemetryLog log(file_name, channels);
+    ASSERT_TRUE(log.good());
+    for (int i = 0; i < n; ++i) {
+      ASSERT_TRUE(log.log(i % 2, {(float)i, 0.5f * i, -1}));
+    }
+  }
+
+  TelemetryReader reader(file_name);
+  ASSERT_TRUE(reader.good());
+  EXPECT_EQ(channels, reader.channels());
+  int channel;
+  std::vector<float> values;
+  for (int i = 0; i < n; ++i) {
+    ASSERT_TRUE(reader.next(channel, values));
+    EXPECT_EQ(i % 2, channel);
+    ASSERT_EQ(3u, values.size());
+    EXPECT_EQ((float)i, values[0]);
+    EXPECT_EQ(0.5f * i, values[1]);
+    EXPECT_EQ(-1, values[2]);
+  }
+  EXPECT_FALSE(reader.next(channel, values));
+  remove(file_name.c_str());
+}
+
+TEST(Telemetry, EveryRecordIsWrittenOrCounted) {
+  std::string file_name = log_name();
+  const int n = 20 * TELEMETRY_CAPACITY;
+  long dropped;
+  {
+    TelemetryLog log(file_name, channels);
+    for (int i = 0; i < n; ++i) {
+      log.log(0, {(float)i});
+      if (i % 1000 == 0) {
+        std::this_thread::yield();
+      }
+    }
+    dropped = log.dropped();
+  }
+
+  TelemetryReader reader(file_name);
+  int channel, read = 0;
+  float last = -1;
+  std::vector<float> values;
+  while (reader.next(channel, values)) {
+    ASSERT_EQ(1u, values.size());
+    ASSERT_LT(last, values[0]); // In order, even with some dropped
+    last = values[0];
+    read++;
+  }
+  EXPECT_EQ(n, read + dropped);
+  remove(file_name.c_str());
+}
+
+TEST(Telemetry, ValuesBeyondTheMaximumAreCut) {
+  std::string file_name = log_name();
+  std::vector<float> many(TELEMETRY_MAX_VALUES + 4, 1);
+  {
+    TelemetryLog log(file_name, channels);
+    log.log(1, &many[0], many.size());
+    log.log(0, NULL, 0);
+  }
+
+  TelemetryReader reader(file_name);
+  int channel;
+  std::vector<float> values;
+  ASSERT_TRUE(reader.next(channel, values));
+  EXPECT_EQ(TELEMETRY_MAX_VALUES, values.size());
+  ASSERT_TRUE(reader.next(channel, values));
+  EXPECT_EQ(0, channel);
+  EXPECT_TRUE(values.empty());
+  remove(file_name.c_str());
+}
+
+TEST(Telemetry, RecordCutShortEndsTheLog) {
+  std::string file_name = log_name();
+  {
+    TelemetryLog log(file_name, channels);
+    log.log(0, {1, 2, 3});
+    log.log(0, {4, 5, 6});
+  }
+  // Half of the last value is missing
+  std::ifstream in(file_name.c_str(), std::ios::binary | std::ios::ate);
+  long size = in.tellg();
+  in.close();
+  ASSERT_EQ(0, truncate(file_name.c_str(), size - 2));
+
+  TelemetryReader reader(file_name);
+  int channel;
+  std::vector<float> values;
+  EXPECT_TRUE(reader.next(channel, values));
+  EXPECT_FALSE(reader.next(channel, values));
+  remove(file_name.c_str());
+}
+
+TEST(Telemetry, TextFileIsNotALog) {
+  std::string file_name = log_name();
+  {
+    std::ofstream text(file_name.c_str());
+    text << "1 2 3 4 5 6 0.1\n";
+  }
+  TelemetryReader reader(file_name);
+  EXPECT_FALSE(reader.good());
+  EXPECT_TRUE(reader.channels().empty());
+  remove(file_name.c_str());
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,56 @@
+#ifndef _CONTROLLERMONITOR_H_
+#define _CONTROLLERMONITOR_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <ros/ros.h>
+#include <controller_manager_msgs/ListControllers.h>
+
+/** Keeps track of whether a ros_control controller is running, from a
+    watcher thread that calls /controller_manager/list_controllers at a
+    bounded rate. This keeps the service call out of the control step:
+    checking the state is just reading the cached value, and waiting for the
+    controller to start blocks on a condition variable. */
+class ControllerMonitor {
+public:
+  /** \param controller Name of the controller to watch.
+      \param idle_rate Polling rate (Hz) when no one is waiting.
+      \param wait_rate Polling rate (Hz) while wait_until_running blocks.
+      \param controller_manager Namespace of the controller manager. */
+  ControllerMonitor(const std::string &controller,
+                    double idle_rate = 10, double wait_rate = 1000,
+                    const std::string &controller_manager = "/controller_manager");
+  ~ControllerMonitor();
+
+  /** The last observed state. Never blocks. */
+  bool running() const { return is_running.load(std::memory_order_acquire); }
+
+  /** Forgets the cached state, eg. after the motors were shut down. States
+      observed from calls that started before this are ignored. */
+  void invalidate();
+
+  /** Waits until the controller is seen running after the last invalidate.
+      \param timeout In seconds.
+      \return Whether it is running. */
+  bool wait_until_running(double timeout);
+
+private:
+  std::string name, service;
+  double idle_period, wait_period;
+  ros::ServiceClient list_controllers;
+
+  std::atomic<bool> is_running, stop;
+  std::atomic<int> waiters;
+  unsigned long generation; // Guarded by mutex
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::thread watcher;
+
+  void watch();
+};
+
+#endif
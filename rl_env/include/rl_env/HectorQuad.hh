@@ -3,9 +3,12 @@
 
 #include <unistd.h>
 #include <utility>
+#include <sstream>
 #include <ros/ros.h>
 
 #include <rl_common/core.hh>
+#include <rl_common/scenario_rng.hh>
+#include <rl_common/telemetry.hh>
 
 // Messages
 #include <std_srvs/Empty.h>
@@ -21,6 +24,8 @@
 #include <controller_manager_msgs/ListControllers.h>
 #include <hector_uav_msgs/MotorPWM.h>
 
+#include <rl_env/ControllerMonitor.hh>
+
 // Trajectories
 #include <rl_env/trajectory/Trajectory.h>
 #include <rl_env/trajectory/WaypointsPoints.h>
@@ -59,8 +64,24 @@
 
 #define TRAIN_PEGASUS false
 #define USE_WIND false
+
+// The wind of an episode comes from its scenario (see ScenarioRng). By
+// default every episode replays the same scenario, so the policies that
+// Pegasus compares fly in the same wind. With a random seed, every episode
+// is a new scenario; still reproducible from the --seed.
 #define USE_RANDOM_SEED false
 
+// Log the state after every physics step (every 0.01 sec) to the
+// quadrotor_substeps.txt channel, from the substeps given back by one run_sim
+// call. Their time is the sim time since the start of the episode, which a
+// float holds to well under a step.
+#define LOG_SUBSTEPS false
+
+// The trajectory and the other samples are logged to the channels of a
+// binary TelemetryLog, quadrotor_log.bin (quadrotor_log_<vehicle>.bin with
+// several vehicles), by a writer thread. telemetry_to_text turns it into the
+// quadrotor_trajectory.txt, quadrotor_data.txt, ... text files.
+
 // Threshold Probability of considering dataset for the trajectory
 // Using for Apprenticeship based method
 // This is done to get a real world implementation where the states
@@ -69,9 +90,21 @@
 
 const double MAX_WIND=5;
 
+// ROS parameter with the configuration() of the env, for the agents whose
+// results depend on it
+#define CONFIGURATION_PARAM "/rl_env/configuration"
+
 class HectorQuad: public Environment {
 public:
-  HectorQuad();
+  /** \param use_gazebo Whether to connect to the gazebo services and the
+      controller manager. Subclasses that simulate the quadrotor themselves
+      pass false, and call reset() once they are set up.
+      \param vehicle Index of the model "quadrotor_<vehicle>" to control, in
+      a world with several of them. Its topics and controller manager are
+      in the namespace of the same name. -1 is the single "quadrotor".
+      \param seed Of the random numbers of the scenarios. */
+  HectorQuad(bool use_gazebo = true, int vehicle = -1, long seed = 1);
+  virtual ~HectorQuad();
 
   virtual const std::vector<float> &sensation();
   virtual float apply(std::vector<float> action);
@@ -79,17 +112,47 @@ public:
   virtual bool terminal();
   virtual void reset();
 
+  /** Sensation after the physics was advanced by someone else, eg. by one
+      run_sim call for all the vehicles in the world (see HectorQuadVec).
+      \param res Response of that run_sim call.
+      \param steps Physics steps that call advanced. */
+  const std::vector<float> &sensation(const rl_common::RLRunSim::Response &res,
+                                      int steps);
+
+  int physics_steps() const { return phy_steps; }
+
+  /** Scenario of the next episodes, from the next reset() on. */
+  void set_scenario(long s) { scenario = s; }
+
+  /** What the return of a policy depends on besides the policy: the kind
+      of env, its seed and its settings. Two envs of the same configuration
+      give the same returns to the same policies. The gazebo world itself is
+      not part of it. */
+  virtual std::string configuration() const;
+
 protected:
   int n_policy, n_state, n_action;
   int phy_steps;
-  long seed;
+  long seed, scenario;
+  ScenarioRng wind_rng, log_rng;
   long long cur_step; // each step is 0.01 sec
+  double sim_time, episode_start; // Of the last state read, and of the reset
+
+  // Which model this is, and where it was spawned
+  int vehicle;
+  std::string model_name, ns;
+  geometry_msgs::Point origin;
+  // Logging, the channels are named after the text files
+  enum LogChannel { TRAJECTORY_LOG, DATA_LOG, SUBSTEP_LOG };
+  std::string log_file, trajectory_file, data_file, substep_file;
+  TelemetryLog* telemetry;
 
   // Publishers, subscribers and services
   ros::Publisher cmd_vel, motor_pwm, command_twist, wind, syscommand, viz_points;
   ros::ServiceClient reset_world, run_sim, pause_phy, engage, shutdown,
                      list_controllers, load_controller, set_model_state;
   std_srvs::Empty empty_msg;
+  ControllerMonitor* controller_monitor; // State of the twist controller
 
   // State and positions
   std::vector<float> s;
@@ -106,6 +169,15 @@ protected:
 
   float reward();
   void get_trajectory(long long time_in_steps = -1);
+  const std::vector<float> &observe(); // State from `current`
+  bool read_state(const rl_common::RLRunSim::Response &res);
+  std::string settings() const; // The part of configuration() in HectorQuad.hh
+  void publish_configuration(); // As CONFIGURATION_PARAM
+
+  // Physics. By default, the quadrotor and its controller run in gazebo.
+  virtual void run_physics(int steps); // Updates `current`
+  virtual void send_command(const geometry_msgs::Twist &twist);
+  virtual void reset_physics(); // Puts the model back at `initial`
 };
 
 #endif
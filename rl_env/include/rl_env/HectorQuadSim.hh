@@ -0,0 +1,34 @@
+#ifndef _HECTORQUADSIM_H_
+#define _HECTORQUADSIM_H_
+
+#include <rl_env/HectorQuad.hh>
+#include <rl_env/sim/QuadrotorSim.h>
+
+/** HectorQuad, with the quadrotor simulated in-process by QuadrotorSim
+    instead of gazebo. State, reward, trajectories, wind and logging are the
+    ones of HectorQuad. The controller gains are read from the parameters
+    loaded from controller.yaml (controller/twist/...), with its values as the
+    defaults so that no parameter server setup is needed. */
+class HectorQuadSim: public HectorQuad {
+public:
+  /** \param payload Whether to simulate (and observe) the payload, like the
+      use_payload model.
+      \param seed Of the random numbers of the scenarios. */
+  HectorQuadSim(bool payload = false, long seed = 1);
+
+  /** With the parameters of the simulated model and controller. */
+  virtual std::string configuration() const;
+
+protected:
+  QuadrotorSim sim;
+  Eigen::Vector3d command_linear;
+  double command_yaw_rate;
+
+  virtual void run_physics(int steps);
+  virtual void send_command(const geometry_msgs::Twist &twist);
+  virtual void reset_physics();
+
+  static QuadrotorSimParams load_params(bool payload);
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef _HECTORQUADVEC_H_
+#define _HECTORQUADVEC_H_
+
+#include <rl_common/vec_env.hh>
+#include <rl_env/HectorQuad.hh>
+
+/** K HectorQuad environments flying the models quadrotor_0 .. quadrotor_<K-1>
+    of one gazebo world. A step applies the actions of all the slots, then
+    advances the world with a single run_sim call whose response holds the
+    states of all the vehicles. So the cost of the gzserver step and of the
+    service round trip is shared by the K rollouts. */
+class HectorQuadVec: public VecEnvironment {
+public:
+  /** \param seed Of the scenarios. All the vehicles replay the same ones. */
+  HectorQuadVec(int vehicles, long seed = 1);
+
+  virtual const float* reset();
+  virtual const float* step(const float* actions);
+  virtual void reset_slot(int slot);
+
+protected:
+  std::vector<HectorQuad*> quads;
+  ros::ServiceClient run_sim;
+  rl_common::RLRunSim msg;
+  std::vector<int> reset_slots; // Slots whose episode ended on this step
+
+  // Steps all the vehicles. The states are in msg.response.
+  void advance(int steps);
+
+  static std::vector<Environment*> create(int vehicles, long seed);
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef _PIPELINEDENV_H_
+#define _PIPELINEDENV_H_
+
+#include <atomic>
+#include <thread>
+
+#include <rl_common/core.hh>
+
+#define PIPELINE_QUEUE_SIZE 4 // Has to be a power of 2
+
+/** Runs an Environment with a one step action delay, optionally on a worker
+    thread so that the physics of the next step overlaps with the agent
+    computing its next action.
+
+    Latency semantics: in the normal (non pipelined) env, the action a(t)
+    computed from state s(t) is applied before the physics that produces
+    s(t+1). Here the physics that produces s(t+1) is started as soon as s(t)
+    has been sent, while the agent is still thinking, and so it runs with the
+    previous action a(t-1) held. a(t) is applied when it arrives and first
+    influences s(t+2). That is, every action is delayed by exactly one
+    control step (phy_steps physics steps, 0.1s for HectorQuad). The reward
+    sent along with s(t+1) is the reward of s(t+1) itself.
+
+    The delay is deterministic: threaded and non threaded runs produce the
+    same trajectories. The non threaded mode is the "delay model", which can
+    be used to train a policy for the delay without the extra thread. */
+class PipelinedEnv {
+public:
+  /** Called (from the worker thread, if threaded) for every state that has
+      to be sent to the agent. */
+  typedef void (*Output)(float reward, const std::vector<float> &state,
+                         bool terminal);
+
+  /** \param env The environment to run. Once the pipeline has started it
+      is only used from the worker thread.
+      \param out Where the states go.
+      \param threaded Overlap the physics with the agent on a worker
+      thread. Otherwise everything runs on the calling thread. */
+  PipelinedEnv(Environment* env, Output out, bool threaded);
+  ~PipelinedEnv();
+
+  /** Sends the initial state and starts the physics of the first step. */
+  void start();
+
+  /** Gives the next action of the agent. Never blocks on the physics when
+      threaded. */
+  void action(const std::vector<float> &a);
+
+  /** Resets the environment and sends the initial state. */
+  void new_episode();
+
+private:
+  struct Command {
+    bool reset;
+    std::vector<float> action;
+  };
+
+  Environment* env;
+  Output out;
+  bool threaded;
+
+  // Lock free single producer (callback thread), single consumer (worker)
+  // queue of commands.
+  Command commands[PIPELINE_QUEUE_SIZE];
+  std::atomic<unsigned> head, tail;
+  std::atomic<bool> running;
+  std::thread worker;
+
+  // Result of the physics step started ahead of time
+  std::vector<float> next_state;
+  bool next_terminal;
+
+  void push(const Command &c);
+  void run();
+  void execute(const Command &c);
+  void send_initial();
+  void prefetch();
+};
+
+#endif
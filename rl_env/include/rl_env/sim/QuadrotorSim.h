@@ -0,0 +1,74 @@
+#ifndef _QUADROTOR_SIM_H_
+#define _QUADROTOR_SIM_H_
+
+#include <Eigen/Geometry>
+
+#include <rl_env/sim/TwistController.h>
+
+// Step size of the physics in quad.world
+#define SIM_STEP_SIZE 0.01
+
+struct QuadrotorSimParams {
+  double mass;
+  Eigen::Vector3d inertia;
+  double gravity;
+
+  // Quadratic drag of quadrotor_aerodynamics.yaml, on the velocity
+  // relative to the wind.
+  double drag_xy, drag_z, drag_moment_xy, drag_moment_z;
+
+  // Payload of quad.gazebo.xacro: hangs from a chain that can only swing
+  // about the body y axis, the joints together within +-swing_limit.
+  bool payload;
+  double payload_mass, chain_length, swing_limit, swing_damping;
+
+  TwistControllerParams controller;
+
+  QuadrotorSimParams();
+};
+
+struct QuadrotorState {
+  Eigen::Vector3d position, velocity; // World frame
+  Eigen::Quaterniond orientation;
+  Eigen::Vector3d angular_velocity; // Body frame
+  double swing, swing_rate; // Payload chain angle about body y
+
+  QuadrotorState();
+};
+
+/** Headless rigid body model of the hector quadrotor in quad.world, flown
+    through the same twist controller cascade. It is deterministic and has no
+    ROS dependencies, so many of them can be stepped in one process. */
+class QuadrotorSim {
+public:
+  QuadrotorSimParams params;
+  QuadrotorState state;
+  TwistController controller;
+
+  QuadrotorSim(const QuadrotorSimParams &p = QuadrotorSimParams());
+
+  /** Puts the quadrotor back on the ground at the origin and clears the
+      controller. */
+  void reset();
+
+  /** Runs the controller and the physics for a number of SIM_STEP_SIZE
+      steps, holding the command and the wind. */
+  void step(int steps, const Eigen::Vector3d &command_linear,
+            double command_yaw_rate, const Eigen::Vector3d &wind);
+
+  /** The link the env observes, like world.cc does: the payload if the model
+      has one, else the base link. */
+  void observed(Eigen::Vector3d &position, Eigen::Vector3d &velocity,
+                Eigen::Quaterniond &orientation,
+                Eigen::Vector3d &angular_velocity) const;
+
+  double time() const { return sim_time; }
+
+private:
+  double sim_time;
+
+  void integrate(double force, const Eigen::Vector3d &torque,
+                 const Eigen::Vector3d &wind, double dt);
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef _TWIST_CONTROLLER_H_
+#define _TWIST_CONTROLLER_H_
+
+#include <Eigen/Geometry>
+
+// Gains of one PID of the hector_quadrotor_controller, as in controller.yaml
+struct PidParams {
+  double k_p, k_i, k_d;
+  double limit_output; // <= 0 means no limit
+  double time_constant; // Of the low pass filter on the input
+
+  PidParams(double p = 0, double i = 0, double d = 0,
+            double limit = -1, double tc = 0);
+};
+
+// Same update rule as hector_quadrotor_controller's PID, so that the gains
+// mean the same thing.
+class Pid {
+public:
+  PidParams params;
+
+  Pid(const PidParams &p = PidParams());
+  void reset();
+
+  // Filters the input, and returns the output for error (input - x) and
+  // the derivative dx of x. The derivative term acts on d(input) - dx.
+  double update(double input, double x, double dx, double dt);
+
+private:
+  bool has_input;
+  double input, integral;
+};
+
+struct TwistControllerParams {
+  PidParams linear_xy, linear_z, angular_xy, angular_z;
+  double load_factor_limit;
+  double force_z_limit, torque_xy_limit, torque_z_limit;
+  double mass;
+  Eigen::Vector3d inertia;
+
+  // The values from HectorQuad/controller.yaml and quad.gazebo.xacro
+  TwistControllerParams();
+};
+
+/** The cascade of the hector TwistController: velocity PIDs give an
+    acceleration command, which gives the thrust and (as a tilt of a/g) the
+    roll/pitch setpoints of the attitude PIDs. The output is the body frame
+    wrench: force along body z and the torques. */
+class TwistController {
+public:
+  TwistControllerParams params;
+
+  TwistController(const TwistControllerParams &p = TwistControllerParams());
+  void reset();
+
+  /** \param command Linear velocity (world frame) and yaw rate command.
+      \param orientation Of the base link.
+      \param velocity Linear velocity of the base link (world frame).
+      \param angular_velocity Of the base link (body frame).
+      \param force Set to the thrust along body z.
+      \param torque Set to the body frame torque. */
+  void update(const Eigen::Vector3d &command_linear, double command_yaw_rate,
+              const Eigen::Quaterniond &orientation,
+              const Eigen::Vector3d &velocity,
+              const Eigen::Vector3d &angular_velocity,
+              double dt, double &force, Eigen::Vector3d &torque);
+
+private:
+  Pid linear_x, linear_y, linear_z, angular_x, angular_y, angular_z;
+};
+
+#endif
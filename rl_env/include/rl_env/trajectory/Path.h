@@ -0,0 +1,63 @@
+#ifndef _PATH_H_
+#define _PATH_H_
+
+#include <vector>
+#include <Eigen/Core>
+#include <geometry_msgs/Point.h>
+
+/** The polyline through the waypoints of a trajectory, with what the
+    trackers ask of it every step precomputed: the arc length at every
+    point, and the length and unit tangent of every segment. Segment i goes
+    from point i to point i + 1. Built once per trajectory.
+
+    Lookups by arc length are binary searches, or walks from a hint that are
+    amortized O(1) when, like the tracked point, the queries only move
+    forward. */
+class Path {
+public:
+  Path() {}
+  Path(const std::vector<geometry_msgs::Point> &points) { build(points); }
+
+  void build(const std::vector<geometry_msgs::Point> &points);
+  void clear();
+
+  bool empty() const { return points.empty(); }
+  size_t size() const { return points.size(); } // Of points
+  size_t segments() const { return lengths.size(); }
+  double length() const { return arc.empty() ? 0 : arc.back(); }
+
+  const Eigen::Vector3d &point(size_t i) const { return points[i]; }
+  double arc_length(size_t i) const { return arc[i]; } // At point i
+
+  /** Unit direction of a segment, 0 for a segment of no length. */
+  const Eigen::Vector3d &tangent(size_t segment) const { return tangents[segment]; }
+  double segment_length(size_t segment) const { return lengths[segment]; }
+
+  /** The segment that arc length s is on, s clamped to the path. */
+  size_t segment_at(double s) const;
+
+  /** Same, walking from the segment `hint` the previous query gave. */
+  size_t segment_at(double s, size_t hint) const;
+
+  /** The point at arc length s, clamped to the ends of the path. */
+  Eigen::Vector3d point_at(double s) const;
+  Eigen::Vector3d point_at(double s, size_t &hint) const;
+
+  /** Projects p on a segment.
+      \param along Set to the distance from the start of the segment to the
+      closest point, within [0, segment_length(segment)].
+      \return The squared distance from p to that point. */
+  double project(const Eigen::Vector3d &p, size_t segment, double &along) const;
+
+  /** The first point from `from` on that is at least `distance` away from
+      p, or the last point if none is before it. */
+  size_t first_beyond(const Eigen::Vector3d &p, size_t from, double distance) const;
+
+private:
+  std::vector<Eigen::Vector3d> points, tangents;
+  std::vector<double> arc, lengths;
+
+  Eigen::Vector3d point_on(size_t segment, double s) const;
+};
+
+#endif
@@ -9,6 +9,17 @@
 #include <visualization_msgs/Marker.h>
 
 #include <rl_env/trajectory/Trajectory.h>
+#include <rl_env/trajectory/Path.h>
+#include <rl_env/trajectory/SegmentBvh.h>
+#include <rl_env/trajectory/VisualizationManager.h>
+
+// When the vehicle is farther than this many lookaheads from the segment it
+// tracks, eg. blown off by the wind, it tracks the closest part of the path
+// instead
+#define REACQUIRE_LOOKAHEADS 2
+// Segments before and after the tracked one that are searched for the
+// closest part. 0 searches the whole path.
+#define REACQUIRE_WINDOW 500
 
 class PurePursuit: public Trajectory {
 /*
@@ -19,11 +30,13 @@ class PurePursuit: public Trajectory {
  public:
   double lookahead;
   std::vector<geometry_msgs::Point> points;
+  Path path; // Through points
+  SegmentBvh segments; // Of path
   long current_point;
   double viz_points_size;
 
   geometry_msgs::Point initial_position, old_target_for_viz;
-  ros::Publisher visualization_publisher;
+  VisualizationManager visualization;
 
   PurePursuit(double l);
   virtual void create_waypoints() = 0;
@@ -39,8 +52,6 @@ class PurePursuit: public Trajectory {
                         geometry_msgs::Vector3 direction);
   void visualize_points();
   gazebo_msgs::ModelState default_target();
-  // Internal functions
-  double distance_points(geometry_msgs::Point a, geometry_msgs::Point b);
 };
 
 #endif
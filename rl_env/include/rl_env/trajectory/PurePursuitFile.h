@@ -4,10 +4,12 @@
 #include <rl_common/core.hh>
 
 #include <rl_env/trajectory/PurePursuit.h>
+#include <rl_env/trajectory/TrajectoryFile.h>
 
 class PurePursuitFile: public PurePursuit {
 private:
   std::string filename;
+  TrajectoryFile samples; // Read once, used by every reset
 public:
   PurePursuitFile(std::string filename, double lookahead);
 
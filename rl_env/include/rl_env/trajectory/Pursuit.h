@@ -9,12 +9,13 @@
 #include <visualization_msgs/Marker.h>
 
 #include <rl_env/trajectory/Trajectory.h>
+#include <rl_env/trajectory/VisualizationManager.h>
 
 class Pursuit: public Trajectory {
   // A generic class which uses pursuit based trajectories.
 public:
   geometry_msgs::Point initial_position, old_target_for_viz;
-  ros::Publisher visualization_publisher;
+  VisualizationManager visualization;
   long long initiating_lag;
 
   double lead_time;
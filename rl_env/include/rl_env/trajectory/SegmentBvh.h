@@ -0,0 +1,65 @@
+#ifndef _SEGMENT_BVH_H_
+#define _SEGMENT_BVH_H_
+
+#include <vector>
+#include <Eigen/Core>
+
+#include <rl_env/trajectory/Path.h>
+
+// Segments in a leaf of the hierarchy
+#define SEGMENT_BVH_LEAF_SIZE 4
+
+/** Bounding volume hierarchy over the segments of a Path, for finding the
+    part of the path closest to a vehicle that was pushed off it.
+
+    A node bounds a contiguous run of segments, which is split in two halves
+    for its children. A path is spatially coherent, so the boxes are tight,
+    and a window of segments maps onto few subtrees. The nodes are in one
+    array, in depth first order.
+
+    Queries descend into the closest box first and skip the boxes farther
+    than the best segment found so far: O(log n) for a path that does not
+    pass through the same place many times. A window restricts them to a
+    range of segments, so that their cost is bounded by its size whatever
+    the length of the path. */
+class SegmentBvh {
+public:
+  struct Hit {
+    size_t segment;
+    double along; // From the start of the segment to the closest point
+    double distance_sq;
+    Eigen::Vector3d point;
+  };
+
+  SegmentBvh() : path(NULL) {}
+
+  /** \param path Is kept, and has to outlive the hierarchy. */
+  void build(const Path &path);
+  void clear();
+  bool empty() const { return nodes.empty(); }
+
+  /** The closest point of the whole path to p. */
+  Hit nearest(const Eigen::Vector3d &p) const;
+
+  /** The closest point of segments first .. last (inclusive) to p.
+      \param hint Among points about as close, the one on the segment
+      closest to the hint is returned, eg. on the lap of a circle that is
+      being flown. */
+  Hit nearest(const Eigen::Vector3d &p, size_t first, size_t last,
+              size_t hint = 0) const;
+
+private:
+  struct Node {
+    Eigen::Vector3d min, max; // Of the box
+    size_t first, last; // Segments, inclusive
+    size_t right; // Second child, the first one is the next node. 0 for a leaf
+  };
+
+  const Path* path;
+  std::vector<Node> nodes;
+
+  size_t build_node(size_t first, size_t last);
+  static double box_distance_sq(const Node &node, const Eigen::Vector3d &p);
+};
+
+#endif
@@ -14,6 +14,7 @@ public:
   bool getting_to_initial_position;
 
   Trajectory();
+  virtual ~Trajectory() {}
 
   // Any code that resets internal state variables which keeps track of
   // the trajectory.
@@ -0,0 +1,70 @@
+#ifndef _TRAJECTORY_FILE_H_
+#define _TRAJECTORY_FILE_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define TRAJECTORY_FILE_MAGIC 0x52544c52 // "RLTR"
+#define TRAJECTORY_FILE_VERSION 1
+
+// One sample of a recorded trajectory, as in the lines of the text files
+struct TrajectoryRecord {
+  float x, y, z, vx, vy, vz, yaw;
+};
+
+/** The samples of a recorded trajectory (eg. the "out" of the
+    apprenticeship scripts), loaded once and kept for every reset.
+
+    The binary format is a Header followed by header.n_records packed
+    TrajectoryRecords, in the byte order of the machine. It is memory mapped
+    read-only and the records are used in place. A text file (x y z vx vy vz
+    yaw per line) is still read, parsed once into memory; trajectory_to_binary
+    converts one to the other. */
+class TrajectoryFile {
+public:
+  struct Header {
+    uint32_t magic, version;
+    uint32_t record_size; // sizeof(TrajectoryRecord)
+    uint32_t reserved;
+    uint64_t n_records;
+  };
+
+  TrajectoryFile(const std::string &file_name);
+  ~TrajectoryFile();
+
+  /** Whether the file was read, in either format. */
+  bool good() const { return data != NULL || !parsed.empty(); }
+  bool mapped() const { return data != NULL; }
+
+  size_t size() const { return n_records; }
+  const TrajectoryRecord* records() const {
+    return data != NULL ? data : (parsed.empty() ? NULL : &parsed[0]);
+  }
+  const TrajectoryRecord &operator[](size_t i) const { return records()[i]; }
+
+  /** Writes records in the binary format.
+      \return Whether the whole file was written. */
+  static bool write(const std::string &file_name,
+                    const std::vector<TrajectoryRecord> &records);
+
+  /** Reads the text format, ignoring lines that do not have 7 numbers. */
+  static bool read_text(const std::string &file_name,
+                        std::vector<TrajectoryRecord> &records);
+
+private:
+  const TrajectoryRecord* data; // In the mapping, NULL if not mapped
+  void* mapping;
+  size_t mapping_size, n_records;
+  std::vector<TrajectoryRecord> parsed; // Of a text file
+
+  // binary is set when the file has the magic number, even if it is not
+  // mapped because it is of another version or cut short
+  bool map(const std::string &file_name, bool &binary);
+
+  // Not copyable, it owns the mapping
+  TrajectoryFile(const TrajectoryFile &);
+  TrajectoryFile &operator=(const TrajectoryFile &);
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef _VISUALIZATION_MANAGER_H_
+#define _VISUALIZATION_MANAGER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#include <ros/ros.h>
+#include <visualization_msgs/Marker.h>
+
+// Whether the trajectories show themselves in rviz (default true). Set it to
+// false for training runs, or use rl_runner --visualization off: no thread
+// is started and the markers are never built, at no cost to the control
+// step.
+#define VISUALIZATION_PARAM "/rl_env/visualization"
+
+// The markers that change every step (the target, its plane or direction)
+// are published at most this many times per second, in wall time
+#define VISUALIZATION_RATE 20
+
+/** Publishes the markers of a trajectory from a thread shared by all the
+    trajectories of the process.
+
+    Geometry that stays the same during an episode, like the waypoints, is
+    published once as a latched visualization_msgs/MarkerArray on
+    visualization_marker_array, and again only when it changes. The
+    changing markers go to visualization_marker; when several updates of
+    one come before it is published, only the last one is. */
+class VisualizationManager {
+public:
+  VisualizationManager();
+  ~VisualizationManager();
+
+  /** VISUALIZATION_PARAM, unless set_enabled was called before. Read once,
+      by the first trajectory created. */
+  static bool enabled();
+  static void set_enabled(bool on);
+
+  /** Adds or replaces (same ns and id) a marker of the static geometry. */
+  void set_static(const visualization_msgs::Marker &marker);
+
+  /** Whether the changing markers of this step will be published. When it
+      returns true, the next check returns true again only a publishing
+      period later, so only steps for which it did build the markers. */
+  bool wants_update() {
+    if (!shared) {
+      return false;
+    }
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now < next_update) {
+      return false;
+    }
+    next_update = now + period;
+    return true;
+  }
+
+  /** Queues a changing marker, replacing one of the same ns and id that was
+      not published yet. */
+  void update(const visualization_msgs::Marker &marker);
+
+private:
+  // The owner, ns and id. The trajectories of the vehicles use the same ns
+  // and id, and each of them has its last marker published.
+  typedef std::tuple<const VisualizationManager*, std::string, int> Key;
+  typedef std::map<Key, visualization_msgs::Marker> Markers;
+
+  // The publishers and the thread, created with the first trajectory and
+  // stopped with the last one
+  struct Shared {
+    ros::Publisher static_publisher, publisher;
+    std::chrono::steady_clock::duration period;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    Markers static_markers, pending;
+    bool static_dirty, running;
+    std::thread thread;
+
+    Shared();
+    ~Shared();
+    void run();
+  };
+
+  static std::mutex instance_mutex; // Of instance
+  static std::weak_ptr<Shared> instance;
+
+  std::shared_ptr<Shared> shared; // NULL when not enabled
+  std::chrono::steady_clock::duration period;
+  std::chrono::steady_clock::time_point next_update; // Of the control thread
+
+  Key key(const visualization_msgs::Marker &marker) const {
+    return Key(this, marker.ns, marker.id);
+  }
+};
+
+#endif
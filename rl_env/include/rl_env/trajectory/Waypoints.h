@@ -9,14 +9,17 @@
 #include <visualization_msgs/Marker.h>
 
 #include <rl_env/trajectory/Trajectory.h>
+#include <rl_env/trajectory/Path.h>
+#include <rl_env/trajectory/VisualizationManager.h>
 
 class Waypoints: public Trajectory {
   // A generic class which uses waypoint based trajectories.
   // Waypoints are calculated based on whether the quad passed the plane
   // of the point or not.
 public:
-  ros::Publisher visualization_publisher;
+  VisualizationManager visualization;
   std::vector<geometry_msgs::Point> points;
+  Path path; // Through points
   long current_point;
   long time_to_get_to_position;
   double epsilon_plane;
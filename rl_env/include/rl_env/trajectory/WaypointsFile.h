@@ -4,10 +4,12 @@
 #include <rl_common/core.hh>
 
 #include <rl_env/trajectory/Waypoints.h>
+#include <rl_env/trajectory/TrajectoryFile.h>
 
 class WaypointsFile: public Waypoints {
 private:
   std::string filename;
+  TrajectoryFile samples; // Read once, used by every reset
 public:
   WaypointsFile(std::string filename, bool _use_checkpoints = false);
 
@@ -0,0 +1,86 @@
+#include <rl_env/ControllerMonitor.hh>
+
+ControllerMonitor::ControllerMonitor(const std::string &controller,
+                                     double idle_rate, double wait_rate,
+                                     const std::string &controller_manager) {
+  name = controller;
+  service = controller_manager + "/list_controllers";
+  idle_period = 1.0 / idle_rate;
+  wait_period = 1.0 / wait_rate;
+  is_running = false;
+  stop = false;
+  waiters = 0;
+  generation = 0;
+
+  ros::NodeHandle node;
+  ros::service::waitForService(service, -1);
+  list_controllers =
+    node.serviceClient<controller_manager_msgs::ListControllers>(service, true);
+
+  watcher = std::thread(&ControllerMonitor::watch, this);
+}
+
+ControllerMonitor::~ControllerMonitor() {
+  stop = true;
+  changed.notify_all();
+  if (watcher.joinable()) {
+    watcher.join();
+  }
+}
+
+void ControllerMonitor::invalidate() {
+  std::lock_guard<std::mutex> lock(mutex);
+  generation += 1;
+  is_running.store(false, std::memory_order_release);
+}
+
+bool ControllerMonitor::wait_until_running(double timeout) {
+  std::unique_lock<std::mutex> lock(mutex);
+  waiters += 1;
+  changed.notify_all(); // Wake the watcher up to poll at the faster rate
+  bool result = changed.wait_for(
+    lock, std::chrono::duration<double>(timeout),
+    [this] { return running() || stop; });
+  waiters -= 1;
+  return result && running();
+}
+
+void ControllerMonitor::watch() {
+  while (!stop && ros::ok()) {
+    unsigned long started;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      started = generation;
+    }
+
+    controller_manager_msgs::ListControllers list_msg;
+    bool found = false, state = false;
+    if (list_controllers.call(list_msg)) {
+      for (size_t i = 0; i < list_msg.response.controller.size(); ++i) {
+        if (list_msg.response.controller[i].name == name) {
+          found = true;
+          state = list_msg.response.controller[i].state == "running";
+        }
+      }
+    } else {
+      // Persistent connections need to be opened again if the
+      // controller manager went away
+      ros::NodeHandle node;
+      list_controllers =
+        node.serviceClient<controller_manager_msgs::ListControllers>(service, true);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (found && started == generation) {
+      // Only use states that were not asked for before an invalidate
+      is_running.store(state, std::memory_order_release);
+      changed.notify_all();
+    }
+
+    double period = waiters > 0 ? wait_period : idle_period;
+    changed.wait_for(lock, std::chrono::duration<double>(period),
+                     [this, period] {
+                       return stop || (waiters > 0 && period > wait_period);
+                     });
+  }
+}
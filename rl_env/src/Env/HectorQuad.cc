@@ -1,6 +1,10 @@
 #include <rl_env/HectorQuad.hh>
+#include <rl_common/stage_profiler.hh>
 
-HectorQuad::HectorQuad()
+#include <sys/stat.h>
+
+HectorQuad::HectorQuad(bool use_gazebo, int v, long sd)
+  : wind_rng(sd, 0, ScenarioRng::WIND), log_rng(sd, 0, ScenarioRng::LOGGING)
 {
   n_action = 4;
   n_state = 8;
@@ -9,11 +13,34 @@ HectorQuad::HectorQuad()
   s.resize(n_state);
   phy_steps = 10;
   cur_step = 0;
+  sim_time = 0;
+  episode_start = 0;
+  seed = sd;
+  scenario = 0;
+  trajectory = NULL;
+
+  vehicle = v;
+  model_name = "quadrotor";
+  ns = "";
+  log_file = "quadrotor_log.bin";
+  trajectory_file = "quadrotor_trajectory.txt";
+  data_file = "quadrotor_data.txt";
+  substep_file = "quadrotor_substeps.txt";
+  if (vehicle >= 0) {
+    std::stringstream index;
+    index << vehicle;
+    model_name += "_" + index.str();
+    ns = "/" + model_name;
+    log_file = "quadrotor_log_" + index.str() + ".bin";
+    trajectory_file = "quadrotor_trajectory_" + index.str() + ".txt";
+    data_file = "quadrotor_data_" + index.str() + ".txt";
+    substep_file = "quadrotor_substeps_" + index.str() + ".txt";
+  }
 
   // Set name of model
-  initial.model_name = "quadrotor";
-  final.model_name = "quadrotor";
-  current.model_name = "quadrotor";
+  initial.model_name = model_name;
+  final.model_name = model_name;
+  current.model_name = model_name;
 
   // initial.model_name = "";
   // final.model_name = "";
@@ -23,12 +50,24 @@ HectorQuad::HectorQuad()
 
   // Publishers
   // cmd_vel = node.advertise<geometry_msgs::Twist>("/cmd_vel", 5);
-  command_twist = node.advertise<geometry_msgs::TwistStamped>("/command/twist", 5);
+  command_twist = node.advertise<geometry_msgs::TwistStamped>(ns + "/command/twist", 5);
   // motor_pwm = node.advertise<hector_uav_msgs::MotorPWM>("/motor_pwm", 5);
-  wind = node.advertise<geometry_msgs::Vector3>("/wind", 5);
+  wind = node.advertise<geometry_msgs::Vector3>(ns + "/wind", 5);
   syscommand = node.advertise<std_msgs::String>("/syscommand", 5);
   viz_points = node.advertise<geometry_msgs::PointStamped>("/visualize_points", 5);
 
+  // Starts a new log, in the order of LogChannel
+  std::vector<std::string> channels;
+  channels.push_back(trajectory_file);
+  channels.push_back(data_file);
+  channels.push_back(substep_file);
+  telemetry = new TelemetryLog(log_file, channels);
+
+  controller_monitor = NULL;
+  if (!use_gazebo) {
+    return;
+  }
+
   // Services
   ros::service::waitForService("/gazebo/reset_world", -1);
   reset_world = node.serviceClient<std_srvs::Empty>("/gazebo/reset_world");
@@ -42,59 +81,85 @@ HectorQuad::HectorQuad()
 
   // Load the controller needed. If this it done in launch file, it doesnt
   // start on time. So, it needs to be done in sync.
-  ros::service::waitForService("/controller_manager/load_controller", -1);
+  ros::service::waitForService(ns + "/controller_manager/load_controller", -1);
   load_controller =
     node.serviceClient<controller_manager_msgs::LoadController>(
-      "/controller_manager/load_controller");
+      ns + "/controller_manager/load_controller");
   controller_manager_msgs::LoadController load_msg;
   load_msg.request.name = "controller/twist";
   load_controller.call(load_msg);
   assert(load_msg.response.ok);
 
   // Check list of controllers loaded
-  ros::service::waitForService("/controller_manager/list_controllers", -1);
+  ros::service::waitForService(ns + "/controller_manager/list_controllers", -1);
   list_controllers =
     node.serviceClient<controller_manager_msgs::ListControllers>(
-      "/controller_manager/list_controllers");
+      ns + "/controller_manager/list_controllers");
   controller_manager_msgs::ListControllers list_msg;
   list_controllers.call(list_msg);
   // The assert assumes that the first controller is twist.
   assert(list_msg.response.controller[0].name == load_msg.request.name);
 
-  ros::service::waitForService("/engage", -1);
-  engage = node.serviceClient<std_srvs::Empty>("/engage");
-  ros::service::waitForService("/shutdown", -1);
-  shutdown = node.serviceClient<std_srvs::Empty>("/shutdown");
-
-  // Delete logging files
-  std::ofstream myfile;
-
-  myfile.open ("quadrotor_trajectory.txt", std::ios::trunc);
-  myfile.close();
-
-  myfile.open ("quadrotor_data.txt", std::ios::trunc);
-  myfile.close();
+  // From here on, the state of the controller is followed in the background
+  // instead of asking for it in every step.
+  controller_monitor = new ControllerMonitor(load_msg.request.name, 10, 1000,
+                                             ns + "/controller_manager");
+
+  ros::service::waitForService(ns + "/engage", -1);
+  engage = node.serviceClient<std_srvs::Empty>(ns + "/engage");
+  ros::service::waitForService(ns + "/shutdown", -1);
+  shutdown = node.serviceClient<std_srvs::Empty>(ns + "/shutdown");
+
+  if (vehicle >= 0) {
+    // Find out where the model was spawned, to put it back there on reset
+    rl_common::RLRunSim msg;
+    msg.request.steps = 0;
+    run_sim.call(msg);
+    read_state(msg.response);
+  }
 
   reset();
+  publish_configuration();
+}
+
+HectorQuad::~HectorQuad() {
+  delete controller_monitor;
+  delete trajectory;
+  delete telemetry; // Writes out what is still queued
 }
 
 const std::vector<float> &HectorQuad::sensation() {
   prev_vel = current.twist;
 
-  // Get state from gazebo and save to "current" state
-  rl_common::RLRunSim msg;
-  msg.request.steps = phy_steps;
+  // Get state from the physics and save to "current" state
   cur_step += phy_steps;
-  run_sim.call(msg);
-  current.pose = msg.response.pose;
-  current.twist = msg.response.twist;
-  get_trajectory();
+  {
+    PROFILE_STAGE("sensation/run_sim");
+    run_physics(phy_steps);
+  }
+  return observe();
+}
+
+const std::vector<float> &HectorQuad::sensation(
+    const rl_common::RLRunSim::Response &res, int steps) {
+  prev_vel = current.twist;
+  cur_step += steps;
+  read_state(res);
+  return observe();
+}
+
+const std::vector<float> &HectorQuad::observe() {
+  {
+    PROFILE_STAGE("sensation/current_target");
+    get_trajectory();
+  }
 
   // Set wind for next turn
   if (USE_WIND) {
-    wind_vel.x += ((double)rand()/RAND_MAX - 0.5) * 2 * MAX_WIND * 0.01;
-    wind_vel.y += ((double)rand()/RAND_MAX - 0.5) * 2 * MAX_WIND * 0.01;
-    wind_vel.z += ((double)rand()/RAND_MAX - 0.5) * 2 * MAX_WIND * 0.01;
+    PROFILE_STAGE("sensation/wind");
+    wind_vel.x += wind_rng.uniform(-MAX_WIND, MAX_WIND) * 0.01;
+    wind_vel.y += wind_rng.uniform(-MAX_WIND, MAX_WIND) * 0.01;
+    wind_vel.z += wind_rng.uniform(-MAX_WIND, MAX_WIND) * 0.01;
     // truncate wind
     wind_vel.x = std::max(wind_vel.x, -MAX_WIND);
     wind_vel.x = std::min(wind_vel.x, MAX_WIND);
@@ -133,22 +198,18 @@ const std::vector<float> &HectorQuad::sensation() {
       + prev_vel.linear.y * prev_vel.linear.y);
 
   // Sample state space as part of trajectory
-  double prob = (double)rand()/RAND_MAX;
+  PROFILE_STAGE("sensation/logging");
+  double prob = log_rng.uniform();
   if (prob < THRESHOLD_PROBABILITY) {
-    std::ofstream myfile;
-    myfile.open ("quadrotor_trajectory.txt", std::ios::app);
-    myfile << current.pose.position.x << " " << current.pose.position.y << " "
-           << current.pose.position.z << " " << current.twist.linear.x << " "
-           << current.twist.linear.y << " " << current.twist.linear.z << " "
-           << current.twist.angular.z << std::endl;
-    myfile.close();
+    telemetry->log(TRAJECTORY_LOG, {
+      (float)current.pose.position.x, (float)current.pose.position.y,
+      (float)current.pose.position.z, (float)current.twist.linear.x,
+      (float)current.twist.linear.y, (float)current.twist.linear.z,
+      (float)current.twist.angular.z});
   }
 
   if (cur_step > 10000) {
-    std::ofstream myfile;
-    myfile.open ("quadrotor_data.txt", std::ios::app);
-    myfile << speed << "\n";
-    myfile.close();
+    telemetry->log(DATA_LOG, {(float)speed});
   }
 
   return s;
@@ -164,12 +225,6 @@ bool HectorQuad::terminal() {
 }
 
 float HectorQuad::apply(std::vector<float> action) {
-  // The below assert is an "in case" - to check whether the controller
-  // is actually engaged before giving the action.
-  controller_manager_msgs::ListControllers list_msg;
-  list_controllers.call(list_msg);
-  assert(list_msg.response.controller[0].state == "running");
-
   // Send action
   assert(action.size() == n_action);
   geometry_msgs::TwistStamped action_vel;
@@ -177,10 +232,127 @@ float HectorQuad::apply(std::vector<float> action) {
   action_vel.twist.linear.y = action[1];
   action_vel.twist.linear.x = action[2];
   action_vel.twist.angular.z = action[3];
-  command_twist.publish(action_vel);
+  {
+    PROFILE_STAGE("apply/command_twist");
+    send_command(action_vel.twist);
+  }
   return reward();
 }
 
+void HectorQuad::run_physics(int steps) {
+  rl_common::RLRunSim msg;
+  msg.request.steps = steps;
+  msg.request.record_substeps = LOG_SUBSTEPS;
+  run_sim.call(msg);
+  read_state(msg.response);
+}
+
+bool HectorQuad::read_state(const rl_common::RLRunSim::Response &res) {
+  int index = -1;
+  if (vehicle < 0) {
+    current.pose = res.pose;
+    current.twist = res.twist;
+    index = 0;
+  } else {
+    for (size_t i = 0; i < res.models.size(); ++i) {
+      if (res.models[i] == model_name) {
+        current.pose = res.poses[i];
+        current.twist = res.twists[i];
+        origin = res.origins[i];
+        index = i;
+      }
+    }
+    if (index < 0) {
+      ROS_WARN("HectorQuad: %s is not in the world", model_name.c_str());
+      return false;
+    }
+  }
+
+  sim_time = res.sim_time.toSec();
+
+  if (LOG_SUBSTEPS && !res.substep_times.empty()) {
+    // time x y z vx vy vz yaw_rate, for this model after every substep. The
+    // absolute sim time is too large for a float after a long run.
+    const int size = rl_common::RLRunSim::Response::SUBSTEP_SIZE;
+    size_t n_models = std::max<size_t>(1, res.models.size());
+    for (size_t i = 0; i < res.substep_times.size(); ++i) {
+      const double* v = &res.substeps[(i * n_models + index) * size];
+      telemetry->log(SUBSTEP_LOG, {
+        (float)(res.substep_times[i] - episode_start),
+        (float)v[0], (float)v[1], (float)v[2],
+        (float)v[7], (float)v[8], (float)v[9], (float)v[12]});
+    }
+  }
+  return res.success;
+}
+
+void HectorQuad::send_command(const geometry_msgs::Twist &twist) {
+  // The below assert is an "in case" - to check whether the controller
+  // is actually engaged before giving the action.
+  assert(controller_monitor->running());
+
+  geometry_msgs::TwistStamped action_vel;
+  action_vel.twist = twist;
+  command_twist.publish(action_vel);
+}
+
+void HectorQuad::reset_physics() {
+  shutdown.call(empty_msg); // shutdown motors
+  controller_monitor->invalidate();
+  geometry_msgs::TwistStamped action_vel; // Set velocity to 0
+
+  // Wait for the controller to go into "running", then we can start getting
+  // actions from the agent.
+  // Until then, keep giving a vel of 0 so that it will auto engage.
+  // std::cout << "HectorQuad : Waiting for controller to engage motors ...\n";
+  do {
+    command_twist.publish(action_vel);
+  } while (!controller_monitor->wait_until_running(0.01));
+
+  // Reset and pause the world
+  // Note: Pause has to be done only after `waitForService` finds the service.
+  //       it cannot be done in gazebo as otherwise waitForService hangs.
+  pause_phy.call(empty_msg);
+  if (vehicle < 0) {
+    reset_world.call(empty_msg);
+  }
+  // With several vehicles, the others are still flying their episodes. Only
+  // this model is put back, at the point it was spawned.
+
+  // set initial position programmatically
+  gazebo_msgs::SetModelState msg;
+  msg.request.model_state = initial;
+  msg.request.model_state.pose.position.x += origin.x;
+  msg.request.model_state.pose.position.y += origin.y;
+  msg.request.model_state.pose.position.z += origin.z;
+  assert(set_model_state.call(msg));
+}
+
+std::string HectorQuad::configuration() const {
+  return "hectorquad " + settings();
+}
+
+std::string HectorQuad::settings() const {
+  std::stringstream c;
+  c << "seed=" << seed << " trajectory=" << TRAJECTORY
+    << " train_pegasus=" << TRAIN_PEGASUS << " wind=" << USE_WIND
+    << " max_wind=" << MAX_WIND << " random_seed=" << USE_RANDOM_SEED
+    << " physics_steps=" << phy_steps;
+
+  if (TRAJECTORY == WAYPOINTS_FILE || TRAJECTORY == PURE_PURSUIT_FILE) {
+    // The file trajectories read "out", which can be recorded again
+    struct stat st;
+    if (stat("out", &st) == 0) {
+      c << " trajectory_file=" << st.st_size << ":" << st.st_mtime;
+    }
+  }
+  return c.str();
+}
+
+void HectorQuad::publish_configuration() {
+  ros::param::set(CONFIGURATION_PARAM, configuration());
+}
+
 float HectorQuad::reward() {
   tf::Quaternion curr_quat;
   double curr_roll, curr_pitch, curr_yaw;
@@ -207,23 +379,7 @@ float HectorQuad::reward() {
 }
 
 void HectorQuad::reset() {
-  shutdown.call(empty_msg); // shutdown motors
-  geometry_msgs::TwistStamped action_vel; // Set velocity to 0
-
-  // Keep checking the status of controller. When it goes into "running"
-  // we can start getting actions from the agent.
-  // Until then, keep giving a vel of 0 so that it will auto engage.
-  // std::cout << "HectorQuad : Waiting for controller to engage motors ...\n";
-  while(1) {
-    controller_manager_msgs::ListControllers list_msg;
-    list_controllers.call(list_msg);
-    command_twist.publish(action_vel);
-
-    usleep(50);
-    if (list_msg.response.controller[0].state == "running")
-      break;
-  }
-
+  PROFILE_STAGE("reset");
   initial.pose.position.x = 0;
   initial.pose.position.y = 0;
   initial.pose.position.z = 0;
@@ -240,76 +396,67 @@ void HectorQuad::reset() {
   wind_vel.y = 0;
   wind_vel.z = 0;
 
-  // Reset and pause the world
-  // Note: Pause has to be done only after `waitForService` finds the service.
-  //       it cannot be done in gazebo as otherwise waitForService hangs.
-  pause_phy.call(empty_msg);
-  reset_world.call(empty_msg);
+  reset_physics();
   cur_step = 0;
-
-  // set initial position programmatically
-  gazebo_msgs::SetModelState msg;
-  msg.request.model_state = initial;
-  assert(set_model_state.call(msg));
+  episode_start = sim_time;
 
   // Reset the trajectory visualizer
   std_msgs::String reset_syscommand;
   reset_syscommand.data = "reset";
   syscommand.publish(reset_syscommand);
 
+  wind_rng.set_scenario(scenario);
+  log_rng.set_scenario(scenario);
+  // Whether to use a new scenario for every episode
+  if (USE_RANDOM_SEED) {
+    scenario++;
+  }
+
   if (USE_WIND) {
-    // Whether to use new random seed for execution
-    if (USE_RANDOM_SEED) {
-      srand(time(NULL));
-    }
-    wind_vel.x = ((double)rand()/RAND_MAX - 0.5) * 2 * MAX_WIND;
-    wind_vel.y = ((double)rand()/RAND_MAX - 0.5) * 2 * MAX_WIND;
-    wind_vel.z = ((double)rand()/RAND_MAX - 0.5) * 2 * MAX_WIND;
+    wind_vel.x = wind_rng.uniform(-MAX_WIND, MAX_WIND);
+    wind_vel.y = wind_rng.uniform(-MAX_WIND, MAX_WIND);
+    wind_vel.z = wind_rng.uniform(-MAX_WIND, MAX_WIND);
     std::cout<<"Wind "<<wind_vel.x<<" "<<wind_vel.y<<" "<<wind_vel.z<<std::endl;
     wind.publish(wind_vel);
   }
 
-  switch(TRAJECTORY) {
-    case WAYPOINTS_CIRCLE:
-      trajectory = new WaypointsPoints<PointsCircle>();
-      trajectory->reset();
-      break;
-    case CHECKPOINTS_CIRCLE:
-      trajectory = new WaypointsPoints<PointsCircle>(true);
-      trajectory->reset();
-      break;
-    case WAYPOINTS_HELIX:
-      trajectory = new WaypointsPoints<PointsHelix>();
-      trajectory->reset();
-      break;
-    case WAYPOINTS_RECTANGLE:
-      trajectory = new WaypointsPoints<PointsRectangle>();
-      trajectory->reset();
-      break;
-    case WAYPOINTS_FILE:
-      trajectory = new WaypointsFile("out");
-      trajectory->reset();
-      break;
-    case PURSUIT_CIRCLE:
-      trajectory = new PursuitCircle();
-      trajectory->reset();
-      break;
-    case PURE_PURSUIT_CIRCLE:
-      trajectory = new PurePursuitPoints<PointsCircle>(0.5);
-      trajectory->reset();
-      break;
-    case PURE_PURSUIT_HELIX:
-      trajectory = new PurePursuitPoints<PointsHelix>(0.5);
-      trajectory->reset();
-      break;
-    case PURE_PURSUIT_RECTANGLE:
-      trajectory = new PurePursuitPoints<PointsRectangle>(1.5);
-      trajectory->reset();
-      break;
-    case PURE_PURSUIT_FILE:
-      trajectory = new PurePursuitFile("out", 0.5);
-      trajectory->reset();
-      break;
+  // The trajectory is created once, and only reset for the next episodes
+  if (trajectory == NULL) {
+    switch(TRAJECTORY) {
+      case WAYPOINTS_CIRCLE:
+        trajectory = new WaypointsPoints<PointsCircle>();
+        break;
+      case CHECKPOINTS_CIRCLE:
+        trajectory = new WaypointsPoints<PointsCircle>(true);
+        break;
+      case WAYPOINTS_HELIX:
+        trajectory = new WaypointsPoints<PointsHelix>();
+        break;
+      case WAYPOINTS_RECTANGLE:
+        trajectory = new WaypointsPoints<PointsRectangle>();
+        break;
+      case WAYPOINTS_FILE:
+        trajectory = new WaypointsFile("out");
+        break;
+      case PURSUIT_CIRCLE:
+        trajectory = new PursuitCircle();
+        break;
+      case PURE_PURSUIT_CIRCLE:
+        trajectory = new PurePursuitPoints<PointsCircle>(0.5);
+        break;
+      case PURE_PURSUIT_HELIX:
+        trajectory = new PurePursuitPoints<PointsHelix>(0.5);
+        break;
+      case PURE_PURSUIT_RECTANGLE:
+        trajectory = new PurePursuitPoints<PointsRectangle>(1.5);
+        break;
+      case PURE_PURSUIT_FILE:
+        trajectory = new PurePursuitFile("out", 0.5);
+        break;
+    }
+  }
+  if (trajectory != NULL) {
+    trajectory->reset();
   }
 
   curr = 1;
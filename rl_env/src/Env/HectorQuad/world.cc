@@ -1,16 +1,25 @@
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 
 #include <rl_common/core.hh>
 #include <ros/ros.h>
 #include <gazebo/gazebo.hh>
 #include <gazebo/physics/Model.hh>
 #include <gazebo/physics/physics.hh>
+#include <gazebo/common/Events.hh>
+#include <boost/bind.hpp>
 #include <rl_common/RLRunSim.h>
 #include <geometry_msgs/Twist.h>
 #include <geometry_msgs/Pose.h>
 
 #define DEBUG 0
 
+// Names of the models that are stepped and reported. A single vehicle is
+// called "quadrotor", several of them "quadrotor_0" .. "quadrotor_<K-1>".
+#define MODEL_NAME "quadrotor"
+
 namespace gazebo {
   class EnvHectorQuadWorld : public WorldPlugin {
   public:
@@ -18,55 +27,118 @@ namespace gazebo {
 
     void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf) {
       world_ptr = _world;
+      model_count = 0;
+      recording = false;
+      update_end = event::Events::ConnectWorldUpdateEnd(
+        boost::bind(&EnvHectorQuadWorld::record_substep, this));
       ros::NodeHandle node;
       run_sim = node.advertiseService("rl_env/run_sim",
                                       &EnvHectorQuadWorld::do_run_sim,
                                       this);
     }
 
-    bool do_run_sim(rl_common::RLRunSim::Request &req,
-                    rl_common::RLRunSim::Response &res) {
-      int step_count = req.steps;
-      world_ptr->StepWorld(step_count);
+    // A quadrotor in the world, and the link its state is taken from
+    struct Vehicle {
+      std::string name;
+      int index;
+      physics::ModelPtr model;
+      physics::LinkPtr link;
+      math::Vector3 origin;
 
-      physics::ModelPtr quad_ptr = world_ptr->GetModel("quadrotor");
-      if ( quad_ptr == NULL ) {
-        res.success = false;
-        return true;
+      bool operator<(const Vehicle &other) const {
+        return index < other.index;
       }
+    };
 
-      // Use payload only if it exists.
-      physics::LinkPtr link_ptr;
-      physics::LinkPtr base_ptr = quad_ptr->GetLink("base_link");
-      physics::LinkPtr payload_ptr = quad_ptr->GetLink("payload");
+    // Looks the vehicles up again only when models were added or removed,
+    // so that a step does not search the world for every one of them.
+    void update_vehicles() {
+      if (world_ptr->GetModelCount() == model_count) {
+        return;
+      }
+      model_count = world_ptr->GetModelCount();
+      vehicles.clear();
 
-      if (payload_ptr) {
-        link_ptr = payload_ptr;
-        if (DEBUG) {
-          ROS_INFO("Using PAYLOAD link for state in world.cc");
+      physics::Model_V models = world_ptr->GetModels();
+      std::string prefix = std::string(MODEL_NAME) + "_";
+      for (size_t i = 0; i < models.size(); ++i) {
+        Vehicle vehicle;
+        vehicle.name = models[i]->GetName();
+        if (vehicle.name == MODEL_NAME) {
+          vehicle.index = -1;
+        } else if (vehicle.name.compare(0, prefix.size(), prefix) == 0) {
+          vehicle.index = atoi(vehicle.name.c_str() + prefix.size());
+        } else {
+          continue;
+        }
+        vehicle.model = models[i];
+
+        // Use payload only if it exists.
+        physics::LinkPtr base_ptr = vehicle.model->GetLink("base_link");
+        physics::LinkPtr payload_ptr = vehicle.model->GetLink("payload");
+        vehicle.link = payload_ptr ? payload_ptr : base_ptr;
+        if (!vehicle.link) {
+          continue;
         }
-      } else {
-        link_ptr = base_ptr;
         if (DEBUG) {
-          ROS_INFO("Using BASE_LINK link for state in world.cc");
+          ROS_INFO("Using %s link of %s for state in world.cc",
+                   payload_ptr ? "PAYLOAD" : "BASE_LINK", vehicle.name.c_str());
         }
+
+        // Vehicles are spawned apart from each other, their states are
+        // given relative to where they started.
+        vehicle.origin = vehicle.model->GetInitialRelativePose().pos;
+        vehicles.push_back(vehicle);
       }
+      std::sort(vehicles.begin(), vehicles.end());
+    }
 
-      if (DEBUG) {
-        if (base_ptr) {
-          std::cout << "Quadrotor Base link\n"
-                    << "Position = " << base_ptr->GetWorldPose().pos << "\n"
-                    << "Orientation = " << base_ptr->GetWorldPose().rot << "\n"
-                    << "Velocity = " << base_ptr->GetWorldLinearVel() << "\n"
-                    << "Ang velocity = " << base_ptr->GetWorldAngularVel() << "\n";
-        }
-        if (payload_ptr) {
-          std::cout << "Payload link\n"
-                    << "Position = " << payload_ptr->GetWorldPose().pos << "\n"
-                    << "Orientation = " << payload_ptr->GetWorldPose().rot << "\n"
-                    << "Velocity = " << payload_ptr->GetWorldLinearVel() << "\n"
-                    << "Ang velocity = " << payload_ptr->GetWorldAngularVel() << "\n";
+    // Called by gazebo after every physics step. While a run_sim asks for
+    // the substeps, the state of every vehicle is appended to its response.
+    void record_substep() {
+      if (!recording) {
+        return;
+      }
+
+      for (size_t i = 0; i < vehicles.size(); ++i) {
+        const Vehicle &vehicle = vehicles[i];
+        math::Pose pose = vehicle.link->GetWorldPose();
+        math::Vector3 lin_vel = vehicle.link->GetWorldLinearVel();
+        math::Vector3 ang_vel = vehicle.link->GetWorldAngularVel();
+        double state[rl_common::RLRunSim::Response::SUBSTEP_SIZE] = {
+          pose.pos.x - vehicle.origin.x, pose.pos.y - vehicle.origin.y,
+          pose.pos.z - vehicle.origin.z,
+          pose.rot.x, pose.rot.y, pose.rot.z, pose.rot.w,
+          lin_vel.x, lin_vel.y, lin_vel.z,
+          ang_vel.x, ang_vel.y, ang_vel.z
+        };
+        recorded->substeps.insert(recorded->substeps.end(), state,
+          state + rl_common::RLRunSim::Response::SUBSTEP_SIZE);
+      }
+      recorded->substep_times.push_back(world_ptr->GetSimTime().Double());
+    }
+
+    bool do_run_sim(rl_common::RLRunSim::Request &req,
+                    rl_common::RLRunSim::Response &res) {
+      int step_count = req.steps;
+      update_vehicles();
+      if (step_count > 0) {
+        if (req.record_substeps) {
+          res.substeps.reserve(step_count * vehicles.size() *
+                               rl_common::RLRunSim::Response::SUBSTEP_SIZE);
+          res.substep_times.reserve(step_count);
+          recorded = &res;
+          recording = true;
         }
+
+        // One step of the world advances all the vehicles
+        world_ptr->StepWorld(step_count);
+        recording = false;
+      }
+
+      if ( vehicles.empty() ) {
+        res.success = false;
+        return true;
       }
       res.success = true;
 
@@ -75,33 +147,65 @@ namespace gazebo {
       res.sim_time.sec = sim_time.sec;
       res.sim_time.nsec = sim_time.nsec;
 
-      // Set pose
-      math::Pose pose = link_ptr->GetWorldPose();
-      res.pose.position.x = pose.pos.x;
-      res.pose.position.y = pose.pos.y;
-      res.pose.position.z = pose.pos.z;
-      res.pose.orientation.x = pose.rot.x;
-      res.pose.orientation.y = pose.rot.y;
-      res.pose.orientation.z = pose.rot.z;
-      res.pose.orientation.w = pose.rot.w;
-
-      // Set twist
-      math::Vector3 lin_vel = link_ptr->GetWorldLinearVel();
-      res.twist.linear.x = lin_vel.x;
-      res.twist.linear.y = lin_vel.y;
-      res.twist.linear.z = lin_vel.z;
-      math::Vector3 ang_vel = link_ptr->GetWorldAngularVel();
-      res.twist.angular.x = ang_vel.x;
-      res.twist.angular.y = ang_vel.y;
-      res.twist.angular.z = ang_vel.z;
+      res.models.resize(vehicles.size());
+      res.poses.resize(vehicles.size());
+      res.twists.resize(vehicles.size());
+      res.origins.resize(vehicles.size());
+      for (size_t i = 0; i < vehicles.size(); ++i) {
+        const Vehicle &vehicle = vehicles[i];
+        res.models[i] = vehicle.name;
+
+        // Set pose
+        math::Pose pose = vehicle.link->GetWorldPose();
+        geometry_msgs::Pose &p = res.poses[i];
+        p.position.x = pose.pos.x - vehicle.origin.x;
+        p.position.y = pose.pos.y - vehicle.origin.y;
+        p.position.z = pose.pos.z - vehicle.origin.z;
+        p.orientation.x = pose.rot.x;
+        p.orientation.y = pose.rot.y;
+        p.orientation.z = pose.rot.z;
+        p.orientation.w = pose.rot.w;
+
+        // Set twist
+        geometry_msgs::Twist &t = res.twists[i];
+        math::Vector3 lin_vel = vehicle.link->GetWorldLinearVel();
+        t.linear.x = lin_vel.x;
+        t.linear.y = lin_vel.y;
+        t.linear.z = lin_vel.z;
+        math::Vector3 ang_vel = vehicle.link->GetWorldAngularVel();
+        t.angular.x = ang_vel.x;
+        t.angular.y = ang_vel.y;
+        t.angular.z = ang_vel.z;
+
+        res.origins[i].x = vehicle.origin.x;
+        res.origins[i].y = vehicle.origin.y;
+        res.origins[i].z = vehicle.origin.z;
+
+        if (DEBUG) {
+          std::cout << vehicle.name << "\n"
+                    << "Position = " << pose.pos << "\n"
+                    << "Orientation = " << pose.rot << "\n"
+                    << "Velocity = " << lin_vel << "\n"
+                    << "Ang velocity = " << ang_vel << "\n";
+        }
+      }
       // std::cout << "Time : " << sim_time.sec << "." << sim_time.nsec
-      //           << "\t\tPos : " << pose.pos.z << "\n";
+      //           << "\t\tPos : " << res.poses[0].position.z << "\n";
 
+      res.pose = res.poses[0];
+      res.twist = res.twists[0];
       return true;
     }
 
     ros::ServiceServer run_sim;
     physics::WorldPtr world_ptr;
+    unsigned int model_count;
+    std::vector<Vehicle> vehicles;
+
+    // Substep recording, see record_substep
+    event::ConnectionPtr update_end;
+    std::atomic<bool> recording; // Set by the service, read by the world thread
+    rl_common::RLRunSim::Response *recorded;
   };
   GZ_REGISTER_WORLD_PLUGIN(EnvHectorQuadWorld)
 }
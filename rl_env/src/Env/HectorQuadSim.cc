@@ -0,0 +1,108 @@
+#include <rl_env/HectorQuadSim.hh>
+
+static void load_pid(ros::NodeHandle &node, const std::string &name,
+                     PidParams &pid) {
+  node.param(name + "/k_p", pid.k_p, pid.k_p);
+  node.param(name + "/k_i", pid.k_i, pid.k_i);
+  node.param(name + "/k_d", pid.k_d, pid.k_d);
+  node.param(name + "/limit_output", pid.limit_output, pid.limit_output);
+  node.param(name + "/time_constant", pid.time_constant, pid.time_constant);
+}
+
+QuadrotorSimParams HectorQuadSim::load_params(bool payload) {
+  QuadrotorSimParams params;
+  params.payload = payload;
+
+  ros::NodeHandle node("controller/twist");
+  TwistControllerParams &c = params.controller;
+  load_pid(node, "linear/xy", c.linear_xy);
+  load_pid(node, "linear/z", c.linear_z);
+  load_pid(node, "angular/xy", c.angular_xy);
+  load_pid(node, "angular/z", c.angular_z);
+  node.param("limits/load_factor", c.load_factor_limit, c.load_factor_limit);
+  node.param("limits/force/z", c.force_z_limit, c.force_z_limit);
+  node.param("limits/torque/xy", c.torque_xy_limit, c.torque_xy_limit);
+  node.param("limits/torque/z", c.torque_z_limit, c.torque_z_limit);
+
+  // quadrotor_aerodynamics.yaml, if loaded
+  ros::NodeHandle aero("quadrotor_aerodynamics");
+  aero.param("C_wxy", params.drag_xy, params.drag_xy);
+  aero.param("C_wz", params.drag_z, params.drag_z);
+  aero.param("C_mxy", params.drag_moment_xy, params.drag_moment_xy);
+  aero.param("C_mz", params.drag_moment_z, params.drag_moment_z);
+  return params;
+}
+
+HectorQuadSim::HectorQuadSim(bool payload, long seed)
+  : HectorQuad(false, -1, seed), sim(load_params(payload)) {
+  command_linear.setZero();
+  command_yaw_rate = 0;
+  reset();
+  publish_configuration();
+}
+
+std::string HectorQuadSim::configuration() const {
+  const QuadrotorSimParams &p = sim.params;
+  const TwistControllerParams &c = p.controller;
+  const PidParams* pids[] = {&c.linear_xy, &c.linear_z, &c.angular_xy,
+                             &c.angular_z};
+
+  std::stringstream s;
+  s.precision(17);
+  s << "quadsim " << settings() << " mass=" << p.mass
+    << " inertia=" << p.inertia.x() << "," << p.inertia.y() << ","
+    << p.inertia.z() << " gravity=" << p.gravity
+    << " drag=" << p.drag_xy << "," << p.drag_z << "," << p.drag_moment_xy
+    << "," << p.drag_moment_z << " payload=" << p.payload;
+  if (p.payload) {
+    s << "," << p.payload_mass << "," << p.chain_length << ","
+      << p.swing_limit << "," << p.swing_damping;
+  }
+  s << " pid=";
+  for (int i = 0; i < 4; ++i) {
+    s << (i > 0 ? ";" : "") << pids[i]->k_p << "," << pids[i]->k_i << ","
+      << pids[i]->k_d << "," << pids[i]->limit_output << ","
+      << pids[i]->time_constant;
+  }
+  s << " limits=" << c.load_factor_limit << "," << c.force_z_limit << ","
+    << c.torque_xy_limit << "," << c.torque_z_limit;
+  return s.str();
+}
+
+void HectorQuadSim::run_physics(int steps) {
+  Eigen::Vector3d wind(wind_vel.x, wind_vel.y, wind_vel.z);
+  sim.step(steps, command_linear, command_yaw_rate, wind);
+
+  Eigen::Vector3d position, velocity, angular_velocity;
+  Eigen::Quaterniond orientation;
+  sim.observed(position, velocity, orientation, angular_velocity);
+
+  current.pose.position.x = position.x();
+  current.pose.position.y = position.y();
+  current.pose.position.z = position.z();
+  current.pose.orientation.x = orientation.x();
+  current.pose.orientation.y = orientation.y();
+  current.pose.orientation.z = orientation.z();
+  current.pose.orientation.w = orientation.w();
+  current.twist.linear.x = velocity.x();
+  current.twist.linear.y = velocity.y();
+  current.twist.linear.z = velocity.z();
+  current.twist.angular.x = angular_velocity.x();
+  current.twist.angular.y = angular_velocity.y();
+  current.twist.angular.z = angular_velocity.z();
+}
+
+void HectorQuadSim::send_command(const geometry_msgs::Twist &twist) {
+  command_linear = Eigen::Vector3d(twist.linear.x, twist.linear.y,
+                                   twist.linear.z);
+  command_yaw_rate = twist.angular.z;
+}
+
+void HectorQuadSim::reset_physics() {
+  // `initial` is always at rest at the origin, which is where the model
+  // starts after a reset
+  sim.reset();
+  command_linear.setZero();
+  command_yaw_rate = 0;
+  current = initial;
+}
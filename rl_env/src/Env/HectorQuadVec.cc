@@ -0,0 +1,101 @@
+#include <rl_env/HectorQuadVec.hh>
+#include <rl_common/stage_profiler.hh>
+
+std::vector<Environment*> HectorQuadVec::create(int vehicles, long seed) {
+  std::vector<Environment*> envs;
+  for (int i = 0; i < vehicles; ++i) {
+    envs.push_back(new HectorQuad(true, i, seed));
+  }
+  return envs;
+}
+
+HectorQuadVec::HectorQuadVec(int vehicles, long seed)
+  : VecEnvironment(create(vehicles, seed), 8, 4) {
+  for (int i = 0; i < n_envs; ++i) {
+    quads.push_back(static_cast<HectorQuad*>(envs[i]));
+  }
+
+  ros::NodeHandle node;
+  ros::service::waitForService("/rl_env/run_sim", -1);
+  run_sim = node.serviceClient<rl_common::RLRunSim>("/rl_env/run_sim", true);
+}
+
+void HectorQuadVec::advance(int steps) {
+  PROFILE_STAGE("sensation/run_sim");
+  msg.request.steps = steps;
+  msg.request.record_substeps = LOG_SUBSTEPS && steps > 0;
+  if (!run_sim.call(msg)) {
+    // Persistent connections need to be opened again if gazebo restarted
+    ros::NodeHandle node;
+    run_sim = node.serviceClient<rl_common::RLRunSim>("/rl_env/run_sim", true);
+    run_sim.call(msg);
+  }
+}
+
+const float* HectorQuadVec::reset() {
+  for (int i = 0; i < n_envs; ++i) {
+    quads[i]->reset();
+    buffer[n_envs * n_state + i] = 0;
+    buffer[n_envs * (n_state + 1) + i] = 0;
+    steps[i] = 0;
+  }
+
+  // Like sensation() after a reset, the physics is run once to get the
+  // first state of the episode.
+  int phy_steps = quads[0]->physics_steps();
+  advance(phy_steps);
+  for (int i = 0; i < n_envs; ++i) {
+    write_state(i, quads[i]->sensation(msg.response, phy_steps));
+  }
+  return states();
+}
+
+const float* HectorQuadVec::step(const float* actions) {
+  for (int i = 0; i < n_envs; ++i) {
+    std::copy(actions + i * n_action, actions + (i + 1) * n_action,
+              action.begin());
+    buffer[n_envs * n_state + i] = quads[i]->apply(action);
+  }
+
+  int phy_steps = quads[0]->physics_steps();
+  advance(phy_steps);
+
+  reset_slots.clear();
+  for (int i = 0; i < n_envs; ++i) {
+    const std::vector<float> &s = quads[i]->sensation(msg.response, phy_steps);
+    bool t = quads[i]->terminal();
+    steps[i] += 1;
+    buffer[n_envs * (n_state + 1) + i] = t ? 1 : 0;
+
+    if (t) {
+      // Only this vehicle is put back, the others keep flying
+      quads[i]->reset();
+      steps[i] = 0;
+      reset_slots.push_back(i);
+    } else {
+      write_state(i, s);
+    }
+  }
+
+  if (!reset_slots.empty()) {
+    // Read the initial state of the new episodes without stepping the
+    // vehicles that are still in their episodes.
+    advance(0);
+    for (size_t j = 0; j < reset_slots.size(); ++j) {
+      int i = reset_slots[j];
+      write_state(i, quads[i]->sensation(msg.response, 0));
+    }
+  }
+  return states();
+}
+
+void HectorQuadVec::reset_slot(int slot) {
+  quads[slot]->reset();
+  buffer[n_envs * n_state + slot] = 0;
+  buffer[n_envs * (n_state + 1) + slot] = 0;
+  steps[slot] = 0;
+
+  // As in step(), the other vehicles are not advanced
+  advance(0);
+  write_state(slot, quads[slot]->sensation(msg.response, 0));
+}
@@ -0,0 +1,108 @@
+#include <rl_env/PipelinedEnv.hh>
+
+#include <sched.h>
+#include <unistd.h>
+
+// Polls of the command queue before the worker starts sleeping between polls
+#define PIPELINE_SPIN_COUNT 10000
+
+PipelinedEnv::PipelinedEnv(Environment* e, Output o, bool t) {
+  env = e;
+  out = o;
+  threaded = t;
+  head = 0;
+  tail = 0;
+  running = false;
+  next_terminal = false;
+}
+
+PipelinedEnv::~PipelinedEnv() {
+  running = false;
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void PipelinedEnv::start() {
+  if (threaded) {
+    running = true;
+    worker = std::thread(&PipelinedEnv::run, this);
+  } else {
+    send_initial();
+  }
+}
+
+void PipelinedEnv::action(const std::vector<float> &a) {
+  Command c;
+  c.reset = false;
+  c.action = a;
+  push(c);
+}
+
+void PipelinedEnv::new_episode() {
+  Command c;
+  c.reset = true;
+  push(c);
+}
+
+void PipelinedEnv::push(const Command &c) {
+  if (!threaded) {
+    execute(c);
+    return;
+  }
+
+  // The agent only has one outstanding message, so this never waits in
+  // practice.
+  unsigned h = head.load(std::memory_order_relaxed);
+  while (h - tail.load(std::memory_order_acquire) >= PIPELINE_QUEUE_SIZE) {
+    sched_yield();
+  }
+  commands[h & (PIPELINE_QUEUE_SIZE - 1)] = c;
+  head.store(h + 1, std::memory_order_release);
+}
+
+void PipelinedEnv::run() {
+  send_initial();
+
+  unsigned t = tail.load(std::memory_order_relaxed);
+  int spin = 0;
+  while (running) {
+    if (head.load(std::memory_order_acquire) == t) {
+      // Nothing to do, which means the agent is slower than the physics
+      if (++spin > PIPELINE_SPIN_COUNT) {
+        usleep(20);
+      }
+      continue;
+    }
+    spin = 0;
+
+    execute(commands[t & (PIPELINE_QUEUE_SIZE - 1)]);
+    t += 1;
+    tail.store(t, std::memory_order_release);
+  }
+}
+
+void PipelinedEnv::execute(const Command &c) {
+  if (c.reset) {
+    env->reset();
+    send_initial();
+    return;
+  }
+
+  // The physics for the state being sent already ran with the previous
+  // action. This one is only used from the next step on.
+  float reward = env->apply(c.action);
+  out(reward, next_state, next_terminal);
+  prefetch();
+}
+
+void PipelinedEnv::send_initial() {
+  out(0, env->sensation(), false);
+  prefetch();
+}
+
+void PipelinedEnv::prefetch() {
+  // Step the physics with whatever action is currently held
+  next_state = env->sensation();
+  next_terminal = env->terminal();
+}
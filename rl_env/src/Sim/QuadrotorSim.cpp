@@ -0,0 +1,152 @@
+#include <rl_env/sim/QuadrotorSim.h>
+
+#include <cmath>
+#include <algorithm>
+
+QuadrotorSimParams::QuadrotorSimParams() {
+  mass = controller.mass;
+  inertia = controller.inertia;
+  gravity = 9.81;
+
+  drag_xy = 0.12;
+  drag_z = 0.1;
+  drag_moment_xy = 0.074156208;
+  drag_moment_z = 0.050643264;
+
+  payload = false;
+  payload_mass = 0.1 + 2 * 0.001; // Payload and the two chain links
+  chain_length = 2 * 0.3;
+  swing_limit = 2 * 0.1;
+  swing_damping = 0.5;
+}
+
+QuadrotorState::QuadrotorState() {
+  position.setZero();
+  velocity.setZero();
+  orientation.setIdentity();
+  angular_velocity.setZero();
+  swing = 0;
+  swing_rate = 0;
+}
+
+QuadrotorSim::QuadrotorSim(const QuadrotorSimParams &p)
+  : params(p), controller(p.controller) {
+  reset();
+}
+
+void QuadrotorSim::reset() {
+  state = QuadrotorState();
+  controller.reset();
+  sim_time = 0;
+}
+
+void QuadrotorSim::step(int steps, const Eigen::Vector3d &command_linear,
+                        double command_yaw_rate, const Eigen::Vector3d &wind) {
+  for (int i = 0; i < steps; ++i) {
+    // The controller runs at the physics rate, as in gazebo_ros_control
+    double force;
+    Eigen::Vector3d torque;
+    controller.update(command_linear, command_yaw_rate, state.orientation,
+                      state.velocity, state.angular_velocity, SIM_STEP_SIZE,
+                      force, torque);
+    integrate(force, torque, wind, SIM_STEP_SIZE);
+    sim_time += SIM_STEP_SIZE;
+  }
+}
+
+void QuadrotorSim::integrate(double force, const Eigen::Vector3d &torque,
+                             const Eigen::Vector3d &wind, double dt) {
+  Eigen::Matrix3d rotation = state.orientation.toRotationMatrix();
+
+  // Aerodynamics, in the body frame
+  Eigen::Vector3d air = rotation.transpose() * (state.velocity - wind);
+  Eigen::Vector3d drag(-params.drag_xy * fabs(air.x()) * air.x(),
+                       -params.drag_xy * fabs(air.y()) * air.y(),
+                       -params.drag_z * fabs(air.z()) * air.z());
+  const Eigen::Vector3d &w = state.angular_velocity;
+  Eigen::Vector3d drag_moment(-params.drag_moment_xy * fabs(w.x()) * w.x(),
+                              -params.drag_moment_xy * fabs(w.y()) * w.y(),
+                              -params.drag_moment_z * fabs(w.z()) * w.z());
+
+  Eigen::Vector3d total_force = rotation * (Eigen::Vector3d(0, 0, force) + drag);
+  total_force.z() -= params.mass * params.gravity;
+
+  if (params.payload) {
+    // Chain swinging in the plane of the body x axis, with the base link's
+    // acceleration as a moving pivot. The tension pulls on the base link.
+    Eigen::Vector3d forward = rotation.col(0);
+    forward.z() = 0;
+    if (forward.norm() > 1e-6) forward.normalize();
+    else forward = Eigen::Vector3d::UnitX();
+
+    Eigen::Vector3d base_acceleration = total_force / params.mass;
+    double a_forward = base_acceleration.dot(forward);
+    double g_effective = params.gravity + base_acceleration.z();
+    double L = params.chain_length;
+
+    double swing_acc = -(g_effective * sin(state.swing) +
+                         a_forward * cos(state.swing)) / L
+                       - params.swing_damping * state.swing_rate;
+    state.swing_rate += swing_acc * dt;
+    state.swing += state.swing_rate * dt;
+    if (fabs(state.swing) > params.swing_limit) {
+      state.swing = std::max(-params.swing_limit,
+                             std::min(params.swing_limit, state.swing));
+      state.swing_rate = 0;
+    }
+
+    double tension = params.payload_mass *
+      (g_effective * cos(state.swing) - a_forward * sin(state.swing) +
+       L * state.swing_rate * state.swing_rate);
+    Eigen::Vector3d chain = forward * sin(state.swing) -
+                            Eigen::Vector3d::UnitZ() * cos(state.swing);
+    total_force += tension * chain;
+  }
+
+  // Semi implicit Euler, the same order of accuracy as ODE's quick step
+  Eigen::Vector3d inertia_w = params.inertia.cwiseProduct(w);
+  Eigen::Vector3d angular_acc =
+    (torque + drag_moment - w.cross(inertia_w)).cwiseQuotient(params.inertia);
+  state.angular_velocity += angular_acc * dt;
+
+  Eigen::Vector3d rotation_vector = state.angular_velocity * dt;
+  double angle = rotation_vector.norm();
+  if (angle > 0) {
+    state.orientation = state.orientation *
+      Eigen::Quaterniond(Eigen::AngleAxisd(angle, rotation_vector / angle));
+    state.orientation.normalize();
+  }
+
+  state.velocity += total_force / params.mass * dt;
+  state.position += state.velocity * dt;
+
+  // Ground plane. The quadrotor can slide on it, the circle trajectories
+  // are flown at z = 0.
+  if (state.position.z() < 0) {
+    state.position.z() = 0;
+    state.velocity.z() = std::max(0.0, state.velocity.z());
+  }
+}
+
+void QuadrotorSim::observed(Eigen::Vector3d &position,
+                            Eigen::Vector3d &velocity,
+                            Eigen::Quaterniond &orientation,
+                            Eigen::Vector3d &angular_velocity) const {
+  position = state.position;
+  velocity = state.velocity;
+  orientation = state.orientation;
+  angular_velocity = state.orientation * state.angular_velocity;
+
+  if (params.payload) {
+    Eigen::Vector3d forward = state.orientation.toRotationMatrix().col(0);
+    forward.z() = 0;
+    if (forward.norm() > 1e-6) forward.normalize();
+    else forward = Eigen::Vector3d::UnitX();
+
+    double L = params.chain_length;
+    position += L * (forward * sin(state.swing) -
+                     Eigen::Vector3d::UnitZ() * cos(state.swing));
+    velocity += L * state.swing_rate * (forward * cos(state.swing) +
+                                        Eigen::Vector3d::UnitZ() * sin(state.swing));
+  }
+}
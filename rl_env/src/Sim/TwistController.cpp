@@ -0,0 +1,130 @@
+#include <rl_env/sim/TwistController.h>
+
+#include <cmath>
+#include <algorithm>
+
+#define GRAVITY 9.8065
+
+static double clamp(double v, double limit) {
+  if (limit <= 0) return v;
+  return std::max(-limit, std::min(limit, v));
+}
+
+PidParams::PidParams(double p, double i, double d, double limit, double tc) {
+  k_p = p;
+  k_i = i;
+  k_d = d;
+  limit_output = limit;
+  time_constant = tc;
+}
+
+Pid::Pid(const PidParams &p) {
+  params = p;
+  reset();
+}
+
+void Pid::reset() {
+  has_input = false;
+  input = 0;
+  integral = 0;
+}
+
+double Pid::update(double in, double x, double dx, double dt) {
+  // Low pass filter on the input
+  if (!has_input) {
+    input = in;
+    has_input = true;
+  }
+  double dinput = 0;
+  if (dt + params.time_constant > 0.0) {
+    dinput = (in - input) / (dt + params.time_constant);
+    input = (dt * in + params.time_constant * input) / (dt + params.time_constant);
+  }
+
+  double error = input - x;
+  integral += error * dt;
+
+  // The derivative of the (filtered) input is fed forward, as in hector's PID
+  double output = params.k_p * error + params.k_i * integral +
+                  params.k_d * (dinput - dx);
+
+  // Anti windup: do not keep integrating while saturated
+  if (params.limit_output > 0 && fabs(output) > params.limit_output) {
+    integral -= error * dt;
+    output = clamp(output, params.limit_output);
+  }
+  return output;
+}
+
+TwistControllerParams::TwistControllerParams() {
+  // controller.yaml: controller/twist
+  linear_xy = PidParams(5.0, 1.0, 0.0, 10.0, 0.05);
+  linear_z = PidParams(5.0, 1.0, 0.0, 10.0, 0.05);
+  angular_xy = PidParams(10.0, 5.0, 5.0, -1, 0.01);
+  angular_z = PidParams(5.0, 2.5, 0.0, 3.0, 0.1);
+  load_factor_limit = 1.5;
+  force_z_limit = 30.0;
+  torque_xy_limit = 10.0;
+  torque_z_limit = 1.0;
+
+  // quad.gazebo.xacro: base_link
+  mass = 1.477;
+  inertia = Eigen::Vector3d(0.01152, 0.01152, 0.0218);
+}
+
+TwistController::TwistController(const TwistControllerParams &p) {
+  params = p;
+  reset();
+}
+
+void TwistController::reset() {
+  linear_x = Pid(params.linear_xy);
+  linear_y = Pid(params.linear_xy);
+  linear_z = Pid(params.linear_z);
+  angular_x = Pid(params.angular_xy);
+  angular_y = Pid(params.angular_xy);
+  angular_z = Pid(params.angular_z);
+}
+
+void TwistController::update(const Eigen::Vector3d &command_linear,
+                             double command_yaw_rate,
+                             const Eigen::Quaterniond &q,
+                             const Eigen::Vector3d &velocity,
+                             const Eigen::Vector3d &angular_velocity,
+                             double dt, double &force, Eigen::Vector3d &torque) {
+  // Thrust has to grow as the quadrotor tilts, up to the load factor limit
+  double load_factor = 1.0 / (q.w() * q.w() - q.x() * q.x() - q.y() * q.y() +
+                              q.z() * q.z());
+  if (!(load_factor > 0 && load_factor < params.load_factor_limit)) {
+    load_factor = params.load_factor_limit;
+  }
+
+  Eigen::Vector3d acceleration;
+  acceleration.x() = linear_x.update(command_linear.x(), velocity.x(), 0, dt);
+  acceleration.y() = linear_y.update(command_linear.y(), velocity.y(), 0, dt);
+  acceleration.z() = linear_z.update(command_linear.z(), velocity.z(), 0, dt) +
+                     GRAVITY;
+
+  // Tilt setpoints from the acceleration in the yaw frame
+  double yaw = atan2(2 * (q.w() * q.z() + q.x() * q.y()),
+                     1 - 2 * (q.y() * q.y() + q.z() * q.z()));
+  double roll = atan2(2 * (q.w() * q.x() + q.y() * q.z()),
+                      1 - 2 * (q.x() * q.x() + q.y() * q.y()));
+  double pitch = asin(std::max(-1.0, std::min(1.0,
+                      2 * (q.w() * q.y() - q.z() * q.x()))));
+  Eigen::Vector3d acceleration_yaw =
+    Eigen::AngleAxisd(-yaw, Eigen::Vector3d::UnitZ()) * acceleration;
+
+  torque.x() = params.inertia.x() * angular_x.update(
+    -acceleration_yaw.y() / GRAVITY, roll, angular_velocity.x(), dt);
+  torque.y() = params.inertia.y() * angular_y.update(
+    acceleration_yaw.x() / GRAVITY, pitch, angular_velocity.y(), dt);
+  torque.z() = params.inertia.z() * angular_z.update(
+    command_yaw_rate, angular_velocity.z(), 0, dt);
+
+  force = params.mass * ((acceleration.z() - GRAVITY) * load_factor + GRAVITY);
+  force = std::max(0.0, std::min(force, params.force_z_limit));
+  torque.x() = clamp(torque.x(), params.torque_xy_limit);
+  torque.y() = clamp(torque.y(), params.torque_xy_limit);
+  torque.z() = clamp(torque.z(), params.torque_z_limit);
+}
@@ -0,0 +1,99 @@
+#include <rl_env/trajectory/Path.h>
+
+#include <algorithm>
+
+void Path::build(const std::vector<geometry_msgs::Point> &waypoints) {
+  clear();
+  size_t n = waypoints.size();
+  points.reserve(n);
+  arc.reserve(n);
+  tangents.reserve(n > 0 ? n - 1 : 0);
+  lengths.reserve(n > 0 ? n - 1 : 0);
+
+  for (size_t i = 0; i < n; ++i) {
+    points.push_back(Eigen::Vector3d(waypoints[i].x, waypoints[i].y, waypoints[i].z));
+    if (i == 0) {
+      arc.push_back(0);
+      continue;
+    }
+
+    Eigen::Vector3d d = points[i] - points[i - 1];
+    double length = d.norm();
+    lengths.push_back(length);
+    tangents.push_back(length > 0 ? Eigen::Vector3d(d / length)
+                                  : Eigen::Vector3d::Zero());
+    arc.push_back(arc.back() + length);
+  }
+}
+
+void Path::clear() {
+  points.clear();
+  tangents.clear();
+  arc.clear();
+  lengths.clear();
+}
+
+size_t Path::segment_at(double s) const {
+  if (lengths.empty()) {
+    return 0;
+  }
+  // The last point with arc <= s starts the segment
+  size_t i = std::upper_bound(arc.begin(), arc.end(), s) - arc.begin();
+  return std::min(i > 0 ? i - 1 : 0, lengths.size() - 1);
+}
+
+size_t Path::segment_at(double s, size_t hint) const {
+  if (lengths.empty()) {
+    return 0;
+  }
+  size_t i = std::min(hint, lengths.size() - 1);
+  if (s < arc[i]) {
+    // Went back: not worth walking
+    return segment_at(s);
+  }
+  while (i + 1 < lengths.size() && arc[i + 1] <= s) {
+    ++i;
+  }
+  return i;
+}
+
+Eigen::Vector3d Path::point_at(double s) const {
+  if (lengths.empty()) {
+    return points.empty() ? Eigen::Vector3d::Zero() : points[0];
+  }
+  return point_on(segment_at(s), s);
+}
+
+Eigen::Vector3d Path::point_at(double s, size_t &hint) const {
+  if (lengths.empty()) {
+    return points.empty() ? Eigen::Vector3d::Zero() : points[0];
+  }
+  hint = segment_at(s, hint);
+  return point_on(hint, s);
+}
+
+Eigen::Vector3d Path::point_on(size_t segment, double s) const {
+  double along = std::max(0.0, std::min(s - arc[segment], lengths[segment]));
+  return points[segment] + along * tangents[segment];
+}
+
+double Path::project(const Eigen::Vector3d &p, size_t segment,
+                     double &along) const {
+  Eigen::Vector3d d = p - points[segment];
+  along = std::max(0.0, std::min(d.dot(tangents[segment]), lengths[segment]));
+  return (d - along * tangents[segment]).squaredNorm();
+}
+
+size_t Path::first_beyond(const Eigen::Vector3d &p, size_t from,
+                          double distance) const {
+  if (points.empty()) {
+    return 0;
+  }
+  double distance_sq = distance * distance;
+  size_t last = points.size() - 1;
+  size_t i = std::min(from, last);
+  while (i < last && (points[i] - p).squaredNorm() < distance_sq) {
+    ++i;
+  }
+  return i;
+}
@@ -13,6 +13,7 @@ PointsHelix::PointsHelix() :
 }
 
 std::vector<geometry_msgs::Point> PointsHelix::get_points() {
+  Points.clear(); // The trajectory may be reset many times
  for (int i = 0; i < points_per_loop * num_loops; ++i) {
     double dir1_val = dir1_center + dir1_radius * sin(2 * M_PI / points_per_loop * i);
     double dir2_val = dir2_center + dir2_radius * cos(2 * M_PI / points_per_loop * i);
@@ -11,6 +11,7 @@ PointsRectangle::PointsRectangle() {
 }
 
 std::vector<geometry_msgs::Point> PointsRectangle::get_points() {
+  Points.clear(); // The trajectory may be reset many times
   geometry_msgs::Point wp;
   double dir1_val, dir2_val, dir3_val;
 
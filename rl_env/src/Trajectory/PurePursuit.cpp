@@ -4,22 +4,23 @@ PurePursuit::PurePursuit(double l) {
   lookahead = l;
 
   viz_points_size = 0.2;
-  // Visualize
-  ros::NodeHandle nh;
-  visualization_publisher = nh.advertise<visualization_msgs::Marker>("visualization_marker", 10);
 }
 
 void PurePursuit::reset() {
-  points.clear();
-  create_waypoints();
+  // The waypoints are the same in every episode, the path is built once
+  if (path.empty()) {
+    points.clear();
+    create_waypoints();
+    path.build(points);
+    segments.build(path);
+    visualize_points();
+  }
   current_point = 0;
-  visualize_points();
+  getting_to_initial_position = true;
 }
 
 gazebo_msgs::ModelState PurePursuit::current_target(long long timestamp,
   gazebo_msgs::ModelState model_state) {
-  geometry_msgs::Point p1 = points[current_point];
-  geometry_msgs::Point p2 = points[current_point];
   geometry_msgs::Point current = model_state.pose.position;
   geometry_msgs::Vector3 direction;
 
@@ -37,45 +38,50 @@ gazebo_msgs::ModelState PurePursuit::current_target(long long timestamp,
     if(current_point == points.size() - 1) {
       target.pose.position = points[points.size()-1];
     } else {
-      int i = 0;
-
-      // Check which waypoint to use for following pursuit
-      // based on the current position of the point and LOOKAHEAD
-      while( distance_points(model_state.pose.position, points[current_point+i]) < lookahead ) {
-        i += 1;
-        if(current_point + i == points.size() - 1) {
-          // Reached final point in the trajectory
-          break;
+      Eigen::Vector3d position(current.x, current.y, current.z);
+
+      // Pushed off the path: the walk below only goes forward, so look for
+      // the closest part of the path around the tracked segment
+      double along, reacquire = REACQUIRE_LOOKAHEADS * lookahead;
+      size_t tracked = current_point - 1;
+      if (path.project(position, tracked, along) > reacquire * reacquire) {
+        size_t first = 0, last = path.segments() - 1;
+        if (REACQUIRE_WINDOW > 0) {
+          first = tracked > REACQUIRE_WINDOW ? tracked - REACQUIRE_WINDOW : 0;
+          last = std::min(last, tracked + REACQUIRE_WINDOW);
         }
+        current_point = segments.nearest(position, first, last, tracked).segment + 1;
       }
 
-      // Set new one as current checkpoint
-      current_point += i;
+      // Check which waypoint to use for following pursuit
+      // based on the current position of the point and LOOKAHEAD.
+      // Apart from re-acquiring, it only moves forward, so an episode
+      // walks the path once.
+      current_point = path.first_beyond(position, current_point, lookahead);
 
-      // Updated goto points
-      p1 = points[current_point-1];
-      p2 = points[current_point];
+      // Updated goto segment, from the previous waypoint to it
+      const Eigen::Vector3d &p1 = path.point(current_point - 1);
+      const Eigen::Vector3d &tangent = path.tangent(current_point - 1);
 
       // Find the projection of the quadrotor
       // position on the trajectory using the dot product
-      double projection = (
-        (p2.x - p1.x) * (current.x - p1.x) +
-        (p2.y - p1.y) * (current.y - p1.y)
-      ) / distance_points(p1, p2);
+      double projection = tangent.x() * (current.x - p1.x()) +
+                          tangent.y() * (current.y - p1.y());
       float lambda = projection + lookahead;
 
-      target.pose.position.x = p1.x + lambda * (p2.x - p1.x) / distance_points(p1, p2);
-      target.pose.position.y = p1.y + lambda * (p2.y - p1.y) / distance_points(p1, p2);
-      target.pose.position.z = p1.z + lambda * (p2.z - p1.z) / distance_points(p1, p2);
+      target.pose.position.x = p1.x() + lambda * tangent.x();
+      target.pose.position.y = p1.y() + lambda * tangent.y();
+      target.pose.position.z = p1.z() + lambda * tangent.z();
 
-      direction.x = p2.x - p1.x;
-      direction.y = p2.y - p1.y;
-      direction.z = p2.z - p1.z;
+      direction.x = tangent.x();
+      direction.y = tangent.y();
+      direction.z = tangent.z();
     }
   }
 
-  visualize_target(target.pose.position, direction);
-  visualize_points();
+  if (visualization.wants_update()) {
+    visualize_target(target.pose.position, direction);
+  }
 
   return target;
 }
@@ -126,7 +132,7 @@ void PurePursuit::visualize_target(geometry_msgs::Point target,
   // Add target to it
   viz_points.points.push_back(target);
 
-  visualization_publisher.publish(viz_points);
+  visualization.update(viz_points);
 
   // Now publish arrow to denote velocity
   visualization_msgs::Marker viz_arrow;
@@ -163,7 +169,7 @@ void PurePursuit::visualize_target(geometry_msgs::Point target,
 
   // std::cout << "Point2:" << point2 << "\n";
 
-  visualization_publisher.publish(viz_arrow);
+  visualization.update(viz_arrow);
 
   old_target_for_viz = target;
 }
@@ -190,13 +196,5 @@ void PurePursuit::visualize_points() {
 
   // Add waypoints to it
   viz_points.points = points;
-  visualization_publisher.publish(viz_points);
+  visualization.set_static(viz_points);
 }
-
-double PurePursuit::distance_points(geometry_msgs::Point a, geometry_msgs::Point b) {
-  return sqrt(
-    ( a.z - b.z ) * ( a.z - b.z ) +
-    ( a.y - b.y ) * ( a.y - b.y ) +
-    ( a.x - b.x ) * ( a.x - b.x )
-  );
-}
\ No newline at end of file
@@ -3,13 +3,12 @@
 Pursuit::Pursuit() {
   lead_time = 1000; // in steps
   initiating_lag = 0;
-
-  // Visualize
-  ros::NodeHandle nh;
-  visualization_publisher = nh.advertise<visualization_msgs::Marker>("visualization_marker", 10);
 }
 
-void Pursuit::reset() {}
+void Pursuit::reset() {
+  initiating_lag = 0;
+  getting_to_initial_position = true;
+}
 
 gazebo_msgs::ModelState Pursuit::current_target(
   long long timestamp,
@@ -33,7 +32,9 @@ gazebo_msgs::ModelState Pursuit::current_target(
     }
     target.pose.position = compute_lead(timestamp - initiating_lag);
   }
-  visualize_target(target.pose.position, target.twist.linear);
+  if (visualization.wants_update()) {
+    visualize_target(target.pose.position, target.twist.linear);
+  }
   return target;
 }
 
@@ -83,7 +84,7 @@ void Pursuit::visualize_target(geometry_msgs::Point target,
   // Add target to it
   viz_points.points.push_back(target);
 
-  visualization_publisher.publish(viz_points);
+  visualization.update(viz_points);
 
   // Now publish arrow to denote velocity
   visualization_msgs::Marker viz_arrow;
@@ -116,7 +117,7 @@ void Pursuit::visualize_target(geometry_msgs::Point target,
   // std::cout << "Target:" << target << "\t";
   // std::cout << "Point2:" << point2 << "\n";
 
-  visualization_publisher.publish(viz_arrow);
+  visualization.update(viz_arrow);
 
   old_target_for_viz = target;
 }
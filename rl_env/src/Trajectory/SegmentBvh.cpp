@@ -0,0 +1,122 @@
+#include <rl_env/trajectory/SegmentBvh.h>
+
+#include <algorithm>
+#include <limits>
+
+// Squared distances (m^2) closer than this are the same
+#define SEGMENT_BVH_TIE 1e-6
+
+namespace {
+
+size_t index_distance(size_t a, size_t b) {
+  return a > b ? a - b : b - a;
+}
+
+} // namespace
+
+void SegmentBvh::build(const Path &p) {
+  clear();
+  path = &p;
+  if (path->segments() == 0) {
+    return;
+  }
+  nodes.reserve(2 * (path->segments() / SEGMENT_BVH_LEAF_SIZE + 1));
+  build_node(0, path->segments() - 1);
+}
+
+void SegmentBvh::clear() {
+  nodes.clear();
+  path = NULL;
+}
+
+size_t SegmentBvh::build_node(size_t first, size_t last) {
+  size_t index = nodes.size();
+  nodes.push_back(Node());
+  nodes[index].first = first;
+  nodes[index].last = last;
+  nodes[index].right = 0;
+
+  if (last - first + 1 <= SEGMENT_BVH_LEAF_SIZE) {
+    // Segment i spans points i and i + 1
+    Eigen::Vector3d min = path->point(first), max = min;
+    for (size_t i = first + 1; i <= last + 1; ++i) {
+      min = min.cwiseMin(path->point(i));
+      max = max.cwiseMax(path->point(i));
+    }
+    nodes[index].min = min;
+    nodes[index].max = max;
+    return index;
+  }
+
+  size_t middle = first + (last - first) / 2;
+  size_t left = build_node(first, middle);
+  size_t right = build_node(middle + 1, last);
+  // nodes may have grown, so no reference is held across the calls
+  nodes[index].right = right;
+  nodes[index].min = nodes[left].min.cwiseMin(nodes[right].min);
+  nodes[index].max = nodes[left].max.cwiseMax(nodes[right].max);
+  return index;
+}
+
+double SegmentBvh::box_distance_sq(const Node &node, const Eigen::Vector3d &p) {
+  Eigen::Vector3d outside = (node.min - p).cwiseMax(p - node.max).cwiseMax(0.0);
+  return outside.squaredNorm();
+}
+
+SegmentBvh::Hit SegmentBvh::nearest(const Eigen::Vector3d &p) const {
+  return nearest(p, 0, std::numeric_limits<size_t>::max());
+}
+
+SegmentBvh::Hit SegmentBvh::nearest(const Eigen::Vector3d &p, size_t first,
+                                    size_t last, size_t hint) const {
+  Hit best;
+  best.segment = 0;
+  best.along = 0;
+  best.distance_sq = std::numeric_limits<double>::infinity();
+  best.point = path != NULL && !path->empty() ? path->point(0)
+                                              : Eigen::Vector3d::Zero();
+  if (nodes.empty()) {
+    return best;
+  }
+
+  // The depth is about log2 of the number of leaves
+  size_t stack[64];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const Node &node = nodes[stack[--top]];
+    if (node.last < first || node.first > last ||
+        box_distance_sq(node, p) > best.distance_sq + SEGMENT_BVH_TIE) {
+      continue;
+    }
+
+    if (node.right == 0) {
+      size_t from = std::max(node.first, first), to = std::min(node.last, last);
+      for (size_t i = from; i <= to; ++i) {
+        double along;
+        double d = path->project(p, i, along);
+        if (d < best.distance_sq - SEGMENT_BVH_TIE ||
+            (d <= best.distance_sq + SEGMENT_BVH_TIE &&
+             index_distance(i, hint) < index_distance(best.segment, hint))) {
+          best.segment = i;
+          best.along = along;
+          best.distance_sq = d;
+        }
+      }
+      continue;
+    }
+
+    // The closer child is visited first, so that it tightens the bound
+    size_t left = &node - &nodes[0] + 1, right = node.right;
+    if (box_distance_sq(nodes[left], p) < box_distance_sq(nodes[right], p)) {
+      std::swap(left, right);
+    }
+    stack[top++] = left;
+    stack[top++] = right;
+  }
+
+  if (best.distance_sq < std::numeric_limits<double>::infinity()) {
+    best.point = path->point(best.segment) + best.along * path->tangent(best.segment);
+  }
+  return best;
+}
@@ -0,0 +1,121 @@
+#include <rl_env/trajectory/TrajectoryFile.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+TrajectoryFile::TrajectoryFile(const std::string &file_name) {
+  data = NULL;
+  mapping = NULL;
+  mapping_size = 0;
+  n_records = 0;
+
+  bool binary = false;
+  if (map(file_name, binary) || binary) {
+    return;
+  }
+  if (read_text(file_name, parsed)) {
+    n_records = parsed.size();
+    std::cout << "TrajectoryFile: Parsed " << n_records << " samples of "
+              << file_name << ", trajectory_to_binary makes a file that can "
+              << "be mapped instead\n";
+  } else {
+    std::cerr << "TrajectoryFile: Cannot read " << file_name << "\n";
+  }
+}
+
+TrajectoryFile::~TrajectoryFile() {
+  if (mapping != NULL) {
+    munmap(mapping, mapping_size);
+  }
+}
+
+bool TrajectoryFile::map(const std::string &file_name, bool &binary) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  Header header;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Header) ||
+      pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+      header.magic != TRAJECTORY_FILE_MAGIC) {
+    // Not a binary trajectory, maybe a text one
+    close(fd);
+    return false;
+  }
+
+  binary = true;
+  if (header.version != TRAJECTORY_FILE_VERSION ||
+      header.record_size != sizeof(TrajectoryRecord) ||
+      header.n_records > (st.st_size - sizeof(Header)) / sizeof(TrajectoryRecord)) {
+    std::cerr << "TrajectoryFile: " << file_name << " is of another version, "
+              << "or cut short\n";
+    close(fd);
+    return false;
+  }
+
+  void* mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // The mapping stays valid
+  if (mem == MAP_FAILED) {
+    std::cerr << "TrajectoryFile: cannot map " << file_name << ": "
+              << strerror(errno) << "\n";
+    return false;
+  }
+
+  mapping = mem;
+  mapping_size = st.st_size;
+  n_records = header.n_records;
+  data = reinterpret_cast<const TrajectoryRecord*>(
+    static_cast<const char*>(mem) + sizeof(Header));
+  return true;
+}
+
+bool TrajectoryFile::write(const std::string &file_name,
+                           const std::vector<TrajectoryRecord> &records) {
+  FILE* file = fopen(file_name.c_str(), "wb");
+  if (file == NULL) {
+    return false;
+  }
+
+  Header header;
+  header.magic = TRAJECTORY_FILE_MAGIC;
+  header.version = TRAJECTORY_FILE_VERSION;
+  header.record_size = sizeof(TrajectoryRecord);
+  header.reserved = 0;
+  header.n_records = records.size();
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  if (ok && !records.empty()) {
+    ok = fwrite(&records[0], sizeof(TrajectoryRecord), records.size(), file) ==
+         records.size();
+  }
+  return fclose(file) == 0 && ok;
+}
+
+bool TrajectoryFile::read_text(const std::string &file_name,
+                               std::vector<TrajectoryRecord> &records) {
+  std::ifstream file(file_name.c_str());
+  if (!file.good()) {
+    return false;
+  }
+
+  records.clear();
+  std::string line;
+  while (std::getline(file, line)) {
+    std::stringstream linestream(line);
+    TrajectoryRecord r;
+    if (linestream >> r.x >> r.y >> r.z >> r.vx >> r.vy >> r.vz >> r.yaw) {
+      records.push_back(r);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,156 @@
+#include <rl_env/trajectory/VisualizationManager.h>
+
+#include <visualization_msgs/MarkerArray.h>
+
+std::mutex VisualizationManager::instance_mutex;
+std::weak_ptr<VisualizationManager::Shared> VisualizationManager::instance;
+
+static std::chrono::steady_clock::duration publish_period() {
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::duration<double>(1.0 / VISUALIZATION_RATE));
+}
+
+static std::mutex switch_mutex;
+static int switch_state = -1; // Not read yet
+
+bool VisualizationManager::enabled() {
+  std::lock_guard<std::mutex> lock(switch_mutex);
+  if (switch_state < 0) {
+    bool on = true;
+    ros::param::get(VISUALIZATION_PARAM, on);
+    switch_state = on;
+  }
+  return switch_state;
+}
+
+void VisualizationManager::set_enabled(bool on) {
+  std::lock_guard<std::mutex> lock(switch_mutex);
+  switch_state = on;
+}
+
+VisualizationManager::VisualizationManager() {
+  period = publish_period();
+  next_update = std::chrono::steady_clock::now();
+  if (!enabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(instance_mutex);
+  shared = instance.lock();
+  if (!shared) {
+    shared = std::make_shared<Shared>();
+    instance = shared;
+  }
+}
+
+VisualizationManager::~VisualizationManager() {
+  if (!shared) {
+    return;
+  }
+  // The markers of a trajectory that is gone are not published any more
+  {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    Markers::iterator it = shared->static_markers.begin();
+    while (it != shared->static_markers.end()) {
+      if (std::get<0>(it->first) == this) {
+        shared->static_markers.erase(it++);
+        shared->static_dirty = true;
+      } else {
+        ++it;
+      }
+    }
+    it = shared->pending.begin();
+    while (it != shared->pending.end()) {
+      if (std::get<0>(it->first) == this) {
+        shared->pending.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+  shared->wake.notify_one();
+
+  std::lock_guard<std::mutex> lock(instance_mutex);
+  shared.reset(); // The last one stops the thread
+}
+
+void VisualizationManager::set_static(const visualization_msgs::Marker &marker) {
+  if (!shared) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    shared->static_markers[key(marker)] = marker;
+    shared->static_dirty = true;
+  }
+  shared->wake.notify_one();
+}
+
+void VisualizationManager::update(const visualization_msgs::Marker &marker) {
+  if (!shared) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    shared->pending[key(marker)] = marker;
+  }
+  shared->wake.notify_one();
+}
+
+VisualizationManager::Shared::Shared() {
+  period = publish_period();
+  static_dirty = false;
+  running = true;
+
+  ros::NodeHandle nh;
+  static_publisher = nh.advertise<visualization_msgs::MarkerArray>(
+    "visualization_marker_array", 1, true);
+  publisher = nh.advertise<visualization_msgs::Marker>("visualization_marker", 10);
+  thread = std::thread(&Shared::run, this);
+}
+
+VisualizationManager::Shared::~Shared() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    running = false;
+  }
+  wake.notify_one();
+  thread.join();
+}
+
+void VisualizationManager::Shared::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    while (running && !static_dirty && pending.empty()) {
+      wake.wait(lock);
+    }
+    if (!running) {
+      break;
+    }
+
+    // Publish without holding the lock, so that the control threads do
+    // not wait for the serialization
+    bool publish_static = static_dirty;
+    visualization_msgs::MarkerArray statics;
+    if (static_dirty) {
+      for (Markers::iterator it = static_markers.begin(); it != static_markers.end(); ++it) {
+        statics.markers.push_back(it->second);
+      }
+      static_dirty = false;
+    }
+    Markers changing;
+    changing.swap(pending);
+    lock.unlock();
+
+    if (publish_static) {
+      static_publisher.publish(statics);
+    }
+    for (Markers::iterator it = changing.begin(); it != changing.end(); ++it) {
+      publisher.publish(it->second);
+    }
+
+    // Whatever comes in meanwhile waits for the next period
+    std::this_thread::sleep_for(period);
+    lock.lock();
+  }
+}
@@ -10,17 +10,18 @@ Waypoints::Waypoints(bool _use_checkpoints /*= false*/) {
   epsilon_z = 1;
 
   use_checkpoint_condition = _use_checkpoints;
-
-  // Visualize waypoints
-  ros::NodeHandle nh;
-  visualization_publisher = nh.advertise<visualization_msgs::Marker>("visualization_marker", 10);
 }
 
 void Waypoints::reset() {
-  points.clear();
-  create_waypoints();
+  // The waypoints are the same in every episode, the path is built once
+  if (path.empty()) {
+    points.clear();
+    create_waypoints();
+    path.build(points);
+    visualize_points();
+  }
   current_point = 1;
-  visualize_points();
+  getting_to_initial_position = true;
 }
 
 gazebo_msgs::ModelState Waypoints::current_target(
@@ -33,6 +34,7 @@ gazebo_msgs::ModelState Waypoints::current_target(
 
   // Set default values of target
   gazebo_msgs::ModelState target = default_target();
+  bool visualize = visualization.wants_update();
 
   // Wait for initial buffer
   if (getting_to_initial_position &&
@@ -46,11 +48,13 @@ gazebo_msgs::ModelState Waypoints::current_target(
       getting_to_initial_position = false;
     }
 
-    // Calculate derivative
+    // Calculate derivative, the segment to the current waypoint
+    Eigen::Vector3d segment = path.tangent(current_point-1) *
+                              path.segment_length(current_point-1);
     geometry_msgs::Vector3 derivative;
-    derivative.x = points[current_point].x - points[current_point-1].x;
-    derivative.y = points[current_point].y - points[current_point-1].y;
-    derivative.z = points[current_point].z - points[current_point-1].z;
+    derivative.x = segment.x();
+    derivative.y = segment.y();
+    derivative.z = segment.z();
 
     if (use_checkpoint_condition) {
       if (is_within(model_state.pose.position, points[current_point],
@@ -80,13 +84,16 @@ gazebo_msgs::ModelState Waypoints::current_target(
       if ( cur_side * old_side <= 0 && current_point != points.size()-1 ) {
         current_point += 1;
       }
-      visualize_plane(plane_point, derivative);
+      if (visualize) {
+        visualize_plane(plane_point, derivative);
+      }
     }
 
     target.pose.position = points[current_point];
   }
-  visualize_points();
-  visualize_target(target.pose.position);
+  if (visualize) {
+    visualize_target(target.pose.position);
+  }
   return target;
 }
 
@@ -143,7 +150,7 @@ void Waypoints::visualize_points() {
   // Add waypoints to it
   viz_points.points = points;
 
-  visualization_publisher.publish(viz_points);
+  visualization.set_static(viz_points);
 }
 
 void Waypoints::visualize_plane(geometry_msgs::Point target, geometry_msgs::Vector3 vec) {
@@ -206,7 +213,7 @@ void Waypoints::visualize_plane(geometry_msgs::Point target, geometry_msgs::Vect
   viz_points.points.push_back(p3);
   viz_points.points.push_back(p4);
   viz_points.points.push_back(p1);
-  visualization_publisher.publish(viz_points);
+  visualization.update(viz_points);
 }
 
 void Waypoints::visualize_target(geometry_msgs::Point target) {
@@ -233,5 +240,5 @@ void Waypoints::visualize_target(geometry_msgs::Point target) {
   // Add target to it
   viz_points.points.push_back(target);
 
-  visualization_publisher.publish(viz_points);
+  visualization.update(viz_points);
 }
@@ -6,8 +6,12 @@
 #include <rl_common/RLExperimentInfo.h>
 
 #include <rl_common/core.hh>
+#include <rl_common/shm_transport.hh>
+#include <rl_common/stage_profiler.hh>
 
 #include <rl_env/HectorQuad.hh>
+#include <rl_env/HectorQuadSim.hh>
+#include <rl_env/PipelinedEnv.hh>
 
 #include <getopt.h>
 #include <stdlib.h>
@@ -19,34 +23,95 @@ static ros::Publisher out_seed;
 Environment* environment;
 int seed = 1;
 std::string env_type = "";
+std::string transport = "ros"; // "ros" topics or "shm" shared memory
+ShmTransport* shm = NULL;
+std::string pipeline = "off"; // "off", "delay" or "on". See PipelinedEnv.hh
+double profile_period = 0; // Seconds between stage latency messages. 0 = off
+PipelinedEnv* pipelined_env = NULL;
 
 void display_help() {
   std::cout << "\n env --env type [options]\n";
   std::cout << "\n Options:\n";
-  std::cout << "--env type (Env types: hectorquad)\n";
+  std::cout << "--env type (Env types: hectorquad, quadsim, quadsim_payload)\n";
+  std::cout << "--seed value (Of the wind scenarios. Default: 1)\n";
+  std::cout << "--transport type (ros or shm. Default: ros)\n";
+  std::cout << "--profile seconds (Publish stage latencies on rl_env/stage_latency\n"
+            << "   every so many seconds and print them at exit. Default: off)\n";
+  std::cout << "--pipeline mode (off, delay or on. Default: off)\n";
+  std::cout << "   delay: Apply every action one step late (delay model)\n";
+  std::cout << "   on: Same as delay, but step the physics while the agent\n"
+            << "       computes the next action\n";
   exit(-1);
 }
 
-void process_action(const rl_common::RLAction::ConstPtr &actionIn) {
-  // Get action from agent and give back the next state
-  rl_common::RLStateReward sr;
-  sr.reward = environment->apply(actionIn->action);
-  sr.state = environment->sensation();
-  sr.terminal = environment->terminal();
+void send_state_reward(float reward, const std::vector<float> &state,
+                       bool terminal) {
+  if (shm != NULL) {
+    ShmStepRecord record;
+    record.kind = ShmStepRecord::STATE;
+    record.reward = reward;
+    record.terminal = terminal;
+    ShmTransport::set_state(record, state);
+    shm->send(record);
+  } else {
+    rl_common::RLStateReward sr;
+    sr.reward = reward;
+    sr.state = state;
+    sr.terminal = terminal;
+    out_env_sr.publish(sr);
+  }
+}
 
-  out_env_sr.publish(sr);
+void step(const std::vector<float> &action) {
+  if (pipelined_env != NULL) {
+    pipelined_env->action(action);
+    return;
+  }
+
+  // Get action from agent and give back the next state
+  PROFILE_STAGE("env/step");
+  float reward = environment->apply(action);
+  const std::vector<float> &state = environment->sensation();
+  send_state_reward(reward, state, environment->terminal());
 }
 
-void process_episode(const rl_common::RLExperimentInfo::ConstPtr &infoIn) {
+void new_episode() {
+  if (pipelined_env != NULL) {
+    pipelined_env->new_episode();
+    return;
+  }
+
   // Process end-of-episode reward info. Mostly to start new episode.
   environment->reset();
+  send_state_reward(0, environment->sensation(), false);
+}
 
-  rl_common::RLStateReward sr;
-  sr.reward = 0;
-  sr.state = environment->sensation();
-  sr.terminal = false;
+void process_action(const rl_common::RLAction::ConstPtr &actionIn) {
+  step(actionIn->action);
+}
 
-  out_env_sr.publish(sr);
+void process_episode(const rl_common::RLExperimentInfo::ConstPtr &infoIn) {
+  new_episode();
+}
+
+void shm_loop() {
+  // Same as the subscribers, but reading from shared memory
+  ShmStepRecord record;
+  std::vector<float> action(SHM_ACTION_SIZE);
+
+  while (ros::ok()) {
+    if (!shm->receive(record, 100)) {
+      ros::spinOnce();
+      continue;
+    }
+
+    if (record.kind == ShmStepRecord::ACTION) {
+      action.assign(record.action, record.action + SHM_ACTION_SIZE);
+      step(action);
+    } else if (record.kind == ShmStepRecord::EPISODE_END) {
+      new_episode();
+    }
+  }
 }
 
 void init_env() {
@@ -54,20 +119,33 @@ void init_env() {
   environment = NULL;
 
   if (env_type == "hectorquad"){
-    environment = new HectorQuad();
+    environment = new HectorQuad(true, -1, seed);
+  } else if (env_type == "quadsim") {
+    environment = new HectorQuadSim(false, seed);
+  } else if (env_type == "quadsim_payload") {
+    environment = new HectorQuadSim(true, seed);
   } else {
     std::cerr << "Invalid env type\n";
     display_help();
     exit(-1);
   }
 
-  // Send first `state`
-  rl_common::RLStateReward sr;
-  sr.reward = 0;
-  sr.state = environment->sensation();
-  sr.terminal = false;
+  if (pipeline != "off") {
+    // Its returns are of the action of a step before (see PipelinedEnv.hh),
+    // so they are part of another configuration
+    std::string configuration;
+    ros::param::get(CONFIGURATION_PARAM, configuration);
+    ros::param::set(CONFIGURATION_PARAM,
+                    configuration + " pipeline=" + pipeline);
+
+    pipelined_env = new PipelinedEnv(environment, send_state_reward,
+                                     pipeline == "on");
+    pipelined_env->start(); // Sends the first `state`
+    return;
+  }
 
-  out_env_sr.publish(sr);
+  // Send first `state`
+  send_state_reward(0, environment->sensation(), false);
 }
 
 int main(int argc, char *argv[]) {
@@ -76,11 +154,14 @@ int main(int argc, char *argv[]) {
 
   // Parse options
   char ch;
-  const char* optflags = "es";
+  const char* optflags = "estpf";
   int option_index = 0;
   static struct option long_options[] = {
     {"env", 1, 0, 'e'},
     {"seed", 1, 0, 's'},
+    {"transport", 1, 0, 't'},
+    {"pipeline", 1, 0, 'p'},
+    {"profile", 1, 0, 'f'},
     {NULL, 0, 0, 0}
   };
 
@@ -96,6 +177,20 @@ int main(int argc, char *argv[]) {
       std::cout << "Using environment type: " << env_type << "\n";
       break;
 
+    case 't':
+      transport = optarg;
+      std::cout << "Using transport: " << transport << "\n";
+      break;
+
+    case 'f':
+      profile_period = std::atof(optarg);
+      break;
+
+    case 'p':
+      pipeline = optarg;
+      std::cout << "Using pipeline: " << pipeline << "\n";
+      break;
+
     default:
       display_help();
       break;
@@ -107,6 +202,30 @@ int main(int argc, char *argv[]) {
     std::cout << "--env not given. Using HectorQuad\n";
   }
 
+  if (pipeline != "off" && pipeline != "delay" && pipeline != "on") {
+    display_help();
+  }
+
+  if (profile_period > 0) {
+    StageProfiler::enable();
+    StageProfiler::start_publishing("rl_env/stage_latency", profile_period);
+  }
+
+  if (transport == "shm") {
+    // Agent and env exchange steps through shared memory instead of topics
+    shm = new ShmTransport(SHM_DEFAULT_NAME, ShmTransport::ENV);
+    init_env();
+    ROS_INFO("RL ENV: starting shared memory loop");
+    shm_loop();
+    delete pipelined_env;
+    delete shm;
+    StageProfiler::stop_publishing();
+    StageProfiler::dump(std::cout);
+    return 0;
+  } else if (transport != "ros") {
+    display_help();
+  }
+
   std::cout << "RL ENV:  Initializing ROS ...\n";
   // Publishers
   out_env_sr = node.advertise<rl_common::RLStateReward>("rl_env/rl_state_reward",
@@ -127,5 +246,8 @@ int main(int argc, char *argv[]) {
   init_env();
   ROS_INFO("RL ENV: starting main loop");
   ros::spin();
+  delete pipelined_env;
+  StageProfiler::stop_publishing();
+  StageProfiler::dump(std::cout);
   return 0;
 }
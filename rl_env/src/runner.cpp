@@ -0,0 +1,517 @@
+#include <ros/ros.h>
+
+#include <rl_common/core.hh>
+#include <rl_common/stage_profiler.hh>
+#include <rl_common/vec_env.hh>
+
+// Agents
+#include <rl_agent/Pegasus.hh>
+#include <rl_agent/PolicySearch.hh>
+#include <rl_agent/Spsa.hh>
+#include <rl_agent/Cmaes.hh>
+#include <rl_agent/policy/Policy.h>
+
+// Environments
+#include <rl_env/HectorQuad.hh>
+#include <rl_env/HectorQuadSim.hh>
+#include <rl_env/HectorQuadVec.hh>
+#include <rl_env/trajectory/VisualizationManager.h>
+
+#include <getopt.h>
+#include <stdlib.h>
+
+// In-process runner: links an Agent and an Environment and drives the episode
+// loop directly through the interfaces in rl_common/core.hh. This gives the
+// same episode semantics as the `agent` + `env` nodes, but without the
+// RLAction / RLStateReward round trip on every step.
+
+Agent* agent = NULL;
+Environment* environment = NULL;
+int seed = 1;
+int max_episodes = -1; // Run forever by default, like the split nodes
+long max_steps = -1; // Per episode. Otherwise, only the env decides the end
+long report_steps = 1000; // Print step statistics after these many steps
+double profile_period = 0; // Seconds between stage latency messages. 0 = off
+int vehicles = 0; // Number of vehicles stepped together. 0 = single env
+int parallel = 0; // Rollout workers of a policy search agent. 0 = off
+int directions = 4; // Perturbations per update of spsa
+int population = 0; // Of cmaes. 0 = its default
+std::string policy_type = "linear"; // Family of the policies searched
+int hidden = 8; // Units of the hidden layer of the neural policy
+
+std::string agent_type = "";
+std::string env_type = "";
+
+// Wall-clock statistics of the steps done since the last report.
+// A step is apply() + sensation() + terminal() + next_action().
+struct StepStats {
+  long steps;
+  double total, min, max; // in seconds
+  ros::WallTime window_start;
+
+  void clear() {
+    steps = 0;
+    total = 0;
+    min = DBL_MAX;
+    max = 0;
+    window_start = ros::WallTime::now();
+  }
+
+  void add(double latency) {
+    steps += 1;
+    total += latency;
+    min = std::min(min, latency);
+    max = std::max(max, latency);
+  }
+
+  void report() {
+    if (steps == 0) return;
+    double elapsed = (ros::WallTime::now() - window_start).toSec();
+    std::cout << "RL RUNNER: " << steps << " steps, "
+              << steps / elapsed << " steps/sec, latency (ms) "
+              << "mean " << 1000 * total / steps
+              << " min " << 1000 * min
+              << " max " << 1000 * max << "\n";
+  }
+};
+
+StepStats stats;
+
+void display_help() {
+  std::cout << "\n rl_runner --agent type --env type [options]\n";
+  std::cout << "\n Options:\n";
+  std::cout << "--agent type (Agent types: pegasus, spsa, cmaes)\n";
+  std::cout << "--env type (Env types: hectorquad, quadsim, quadsim_payload)\n";
+  std::cout << "--seed value (Of the wind scenarios, the spsa directions and\n"
+            << "   the cmaes samples. Default: 1)\n";
+  std::cout << "--directions k (Antithetic pairs per spsa update. Default: 4)\n";
+  std::cout << "--population n (Of the first cmaes generation.\n"
+            << "   Default: 4 + 3 ln(number of parameters))\n";
+  std::cout << "--policy type (Policies searched: linear (8 gains) or neural.\n"
+            << "   Default: linear)\n";
+  std::cout << "--hidden n (Units of the hidden layer of the neural policy,\n"
+            << "   0 for none. Default: 8)\n";
+  std::cout << "--episodes n (Number of episodes to run. Default: forever)\n";
+  std::cout << "--max-steps n (Maximum actions per episode. Default: env decides)\n";
+  std::cout << "--report n (Print step statistics every n steps. Default: 1000)\n";
+  std::cout << "--profile seconds (Publish stage latencies on rl_env/stage_latency\n"
+            << "   every so many seconds and print them at exit. Default: off)\n";
+  std::cout << "--vehicles k (Fly quadrotor_0 .. quadrotor_<k-1> of one gazebo\n"
+            << "   world with one agent each, stepping them all at once.\n"
+            << "   With quadsim, k independent models. --max-steps is not used.\n"
+            << "   Agent i keeps its policy in policy_<i>.txt, its\n"
+            << "   checkpoint in <agent>_checkpoint_<i>.txt and pegasus its\n"
+            << "   cache in policy_cache_<i>.bin. Default: off)\n";
+  std::cout << "--parallel k (Evaluate the policies that a policy search agent\n"
+            << "   needs for an update on k envs at once, as for --vehicles.\n"
+            << "   Default: off)\n";
+  std::cout << "--visualization on|off (Publish the trajectories to rviz.\n"
+            << "   Default: the " << VISUALIZATION_PARAM << " param, or on)\n";
+  exit(-1);
+}
+
+Policy* create_policy() {
+  Policy* policy = Policy::create(policy_type, 8, 4, hidden, seed);
+  if (policy == NULL) {
+    std::cout << "Invalid Policy!" << std::endl;
+    display_help();
+  }
+  return policy;
+}
+
+// instance: Of the agent among those of --vehicles, -1 for the only one
+Agent* create_agent(int instance = -1) {
+  if (agent_type == "pegasus"){
+    std::cout << "Agent: Pegasus" << std::endl;
+    // The envs are created first, and publish their configuration
+    std::string configuration;
+    ros::param::get(CONFIGURATION_PARAM, configuration);
+    return new Pegasus(create_policy(), configuration, instance);
+  } else if (agent_type == "spsa") {
+    std::cout << "Agent: SPSA" << std::endl;
+    return new Spsa(seed, directions, create_policy(), instance);
+  } else if (agent_type == "cmaes") {
+    std::cout << "Agent: CMA-ES" << std::endl;
+    return new Cmaes(seed, population, create_policy(), instance);
+  }
+  std::cout << "Invalid Agent!" << std::endl;
+  display_help();
+  return NULL;
+}
+
+void init_agent() {
+  agent = create_agent();
+}
+
+void init_env() {
+  environment = NULL;
+
+  if (env_type == "hectorquad"){
+    environment = new HectorQuad(true, -1, seed);
+  } else if (env_type == "quadsim") {
+    environment = new HectorQuadSim(false, seed);
+  } else if (env_type == "quadsim_payload") {
+    environment = new HectorQuadSim(true, seed);
+  } else {
+    std::cerr << "Invalid env type\n";
+    display_help();
+  }
+}
+
+// k environments stepped as one batch, for --vehicles and --parallel
+VecEnvironment* create_vec_env(int k) {
+  if (env_type == "hectorquad") {
+    return new HectorQuadVec(k, seed);
+  }
+
+  std::vector<Environment*> envs;
+  for (int i = 0; i < k; ++i) {
+    if (env_type == "quadsim") {
+      envs.push_back(new HectorQuadSim(false, seed));
+    } else if (env_type == "quadsim_payload") {
+      envs.push_back(new HectorQuadSim(true, seed));
+    } else {
+      std::cerr << "Invalid env type\n";
+      display_help();
+    }
+  }
+  return new VecEnvironment(envs, 8, 4);
+}
+
+float run_episode(long &number_actions) {
+  // The environment is in an initial state here, either just after being
+  // constructed or after the reset() at the end of the previous episode.
+  std::vector<float> action = agent->first_action(environment->sensation());
+  float episode_reward = 0;
+  number_actions = 1;
+
+  while (ros::ok()) {
+    ros::WallTime step_start = ros::WallTime::now();
+
+    float reward = environment->apply(action);
+    const std::vector<float> &state = environment->sensation();
+    bool terminal = environment->terminal() ||
+                    (max_steps > 0 && number_actions >= max_steps);
+    episode_reward += reward;
+
+    if (terminal) {
+      agent->last_action(reward);
+      break;
+    }
+
+    {
+      PROFILE_STAGE("runner/next_action");
+      action = agent->next_action(reward, state);
+    }
+    number_actions += 1;
+
+    stats.add((ros::WallTime::now() - step_start).toSec());
+    if (stats.steps >= report_steps) {
+      stats.report();
+      stats.clear();
+    }
+  }
+
+  return episode_reward;
+}
+
+// Runs one agent per vehicle against a HectorQuadVec. Episodes end
+// independently in each slot, and are counted together for --episodes.
+void run_vehicles() {
+  VecEnvironment &env = *create_vec_env(vehicles);
+  std::vector<Agent*> agents;
+  for (int i = 0; i < vehicles; ++i) {
+    // Each one keeps its policy, checkpoint and cache in files of its own
+    agents.push_back(create_agent(i));
+  }
+  VecAgentAdapter adapter(agents, env.action_size());
+
+  std::vector<float> episode_rewards(vehicles, 0);
+  int episode = 0;
+
+  ROS_INFO("RL RUNNER: starting main loop with %d vehicles", vehicles);
+  stats.clear();
+  env.reset();
+  const float* actions = adapter.first_actions(env);
+  while (ros::ok()) {
+    ros::WallTime step_start = ros::WallTime::now();
+    env.step(actions);
+
+    bool done = false;
+    for (int i = 0; i < vehicles; ++i) {
+      episode_rewards[i] += env.rewards()[i];
+      if (env.terminals()[i]) {
+        episode += 1;
+        std::cout << "RL RUNNER: Episode " << episode << " (vehicle " << i
+                  << "), Episode Reward: " << episode_rewards[i] << "\n";
+        episode_rewards[i] = 0;
+        done = done || (max_episodes > 0 && episode >= max_episodes);
+      }
+    }
+    if (done) {
+      // The episodes that just ended still get their last reward
+      adapter.last_actions(env);
+      break;
+    }
+
+    {
+      PROFILE_STAGE("runner/next_action");
+      actions = adapter.next_actions(env);
+    }
+
+    // One step of all the vehicles
+    stats.add((ros::WallTime::now() - step_start).toSec());
+    if (stats.steps >= report_steps) {
+      stats.report();
+      stats.clear();
+    }
+  }
+  stats.report();
+
+  for (int i = 0; i < vehicles; ++i) {
+    delete agents[i];
+  }
+  delete &env;
+}
+
+// Evaluates the waves of a policy search agent on a pool of envs. Every
+// slot runs an episode of one policy of the wave, and takes the next policy
+// that is not being evaluated when it is done. The update is made by the
+// agent once all the returns of the wave have been reported.
+void run_pool() {
+  VecEnvironment* env = create_vec_env(parallel);
+  init_agent();
+  PolicySearch* search = dynamic_cast<PolicySearch*>(agent);
+  if (search == NULL) {
+    std::cerr << "--parallel needs a policy search agent\n";
+    display_help();
+  }
+  int n_state = env->state_size(), n_action = env->action_size();
+  std::vector<float> actions(parallel * n_action, 0);
+
+  // The policy of the wave each slot evaluates, -1 when idle. Idle slots
+  // hover with zero actions, and are reset before they get a policy.
+  std::vector<int> assigned(parallel, -1);
+  std::vector<bool> fresh(parallel, true); // At the start of an episode
+  std::vector<float> values(parallel, 0), episode_rewards(parallel, 0);
+  std::vector<long> number_actions(parallel, 0);
+  int next = 0; // Next policy of the wave to hand out
+  int episode = 0;
+
+  ROS_INFO("RL RUNNER: starting main loop with %d workers", parallel);
+  stats.clear();
+  env->reset();
+  while (ros::ok()) {
+    for (int i = 0; i < parallel; ++i) {
+      if (assigned[i] >= 0 || next >= search->wave_size()) continue;
+      if (!fresh[i]) env->reset_slot(i);
+      assigned[i] = next++;
+      values[i] = 0;
+      episode_rewards[i] = 0;
+      number_actions[i] = 0;
+    }
+
+    ros::WallTime step_start = ros::WallTime::now();
+    {
+      PROFILE_STAGE("runner/next_action");
+      for (int i = 0; i < parallel; ++i) {
+        float* a = &actions[i * n_action];
+        if (assigned[i] < 0) {
+          std::fill(a, a + n_action, 0);
+          continue;
+        }
+        search->get_action(search->wave_policy(assigned[i]),
+                           env->states() + i * n_state, a);
+        number_actions[i] += 1;
+      }
+    }
+    env->step(&actions[0]);
+
+    bool done = false;
+    for (int i = 0; i < parallel; ++i) {
+      bool terminal = env->terminals()[i];
+      fresh[i] = terminal; // The env resets the slots whose episode ended
+      if (assigned[i] < 0) continue;
+
+      float reward = env->rewards()[i];
+      // To the agent, the discounted return of the episode
+      values[i] = search->discount() * values[i] + reward;
+      episode_rewards[i] += reward;
+      if (!terminal && !(max_steps > 0 && number_actions[i] >= max_steps)) {
+        continue;
+      }
+
+      episode += 1;
+      std::cout << "RL RUNNER: Episode " << episode << " (worker " << i
+                << "), #Actions " << number_actions[i]
+                << ", Episode Reward: " << episode_rewards[i] << "\n";
+      if (search->report(assigned[i], values[i])) {
+        // All of the wave was reported, so no slot is evaluating it
+        next = 0;
+      }
+      assigned[i] = -1;
+      done = done || (max_episodes > 0 && episode >= max_episodes);
+    }
+    if (done) break;
+
+    // One step of all the workers
+    stats.add((ros::WallTime::now() - step_start).toSec());
+    if (stats.steps >= report_steps) {
+      stats.report();
+      stats.clear();
+    }
+  }
+  stats.report();
+
+  delete env;
+}
+
+int main(int argc, char *argv[]) {
+  ros::init(argc, argv, "RLRunner");
+  ros::NodeHandle node;
+
+  char ch;
+  const char* optflags = "aesnmrfvpdolhz";
+  int option_index = 0;
+  static struct option long_options[] = {
+    {"agent", 1, 0, 'a'},
+    {"env", 1, 0, 'e'},
+    {"seed", 1, 0, 's'},
+    {"episodes", 1, 0, 'n'},
+    {"max-steps", 1, 0, 'm'},
+    {"report", 1, 0, 'r'},
+    {"profile", 1, 0, 'f'},
+    {"vehicles", 1, 0, 'v'},
+    {"parallel", 1, 0, 'p'},
+    {"directions", 1, 0, 'd'},
+    {"population", 1, 0, 'o'},
+    {"policy", 1, 0, 'l'},
+    {"hidden", 1, 0, 'h'},
+    {"visualization", 1, 0, 'z'},
+    {NULL, 0, 0, 0}
+  };
+
+  while(-1 != (ch = getopt_long_only(argc, argv, optflags, long_options, &option_index))) {
+    switch(ch) {
+    case 'a':
+      agent_type = optarg;
+      std::cout << "Using agent: " << agent_type << "\n";
+      break;
+
+    case 'e':
+      env_type = optarg;
+      std::cout << "Using environment type: " << env_type << "\n";
+      break;
+
+    case 's':
+      seed = std::atoi(optarg);
+      std::cout << "Using seed: " << seed << "\n";
+      break;
+
+    case 'n':
+      max_episodes = std::atoi(optarg);
+      break;
+
+    case 'm':
+      max_steps = std::atol(optarg);
+      break;
+
+    case 'r':
+      report_steps = std::max(1L, std::atol(optarg));
+      break;
+
+    case 'f':
+      profile_period = std::atof(optarg);
+      break;
+
+    case 'v':
+      vehicles = std::atoi(optarg);
+      break;
+
+    case 'p':
+      parallel = std::atoi(optarg);
+      break;
+
+    case 'd':
+      directions = std::atoi(optarg);
+      break;
+
+    case 'o':
+      population = std::atoi(optarg);
+      break;
+
+    case 'l':
+      policy_type = optarg;
+      std::cout << "Using policy: " << policy_type << "\n";
+      break;
+
+    case 'h':
+      hidden = std::atoi(optarg);
+      break;
+
+    case 'z':
+      VisualizationManager::set_enabled(std::string(optarg) != "off");
+      break;
+
+    default:
+      display_help();
+      break;
+    }
+  }
+
+  if (agent_type == "") {
+    display_help();
+  }
+
+  if (env_type == ""){
+    env_type = "hectorquad";
+    std::cout << "--env not given. Using HectorQuad\n";
+  }
+
+  if (profile_period > 0) {
+    StageProfiler::enable();
+    StageProfiler::start_publishing("rl_env/stage_latency", profile_period);
+  }
+
+  if (vehicles > 0) {
+    run_vehicles();
+    StageProfiler::stop_publishing();
+    StageProfiler::dump(std::cout);
+    return 0;
+  }
+
+  if (parallel > 0) {
+    run_pool();
+    StageProfiler::stop_publishing();
+    StageProfiler::dump(std::cout);
+    delete agent;
+    return 0;
+  }
+
+  init_env();
+  init_agent();
+
+  ROS_INFO("RL RUNNER: starting main loop");
+  stats.clear();
+  for (int episode = 1; ros::ok(); ++episode) {
+    long number_actions;
+    ros::WallTime episode_start = ros::WallTime::now();
+    float episode_reward = run_episode(number_actions);
+    double elapsed = (ros::WallTime::now() - episode_start).toSec();
+
+    std::cout << "RL RUNNER: Episode " << episode
+              << ", #Actions " << number_actions
+              << ", Episode Reward: " << episode_reward
+              << ", " << number_actions / elapsed << " steps/sec\n";
+
+    if (max_episodes > 0 && episode >= max_episodes) break;
+    environment->reset();
+  }
+  stats.report();
+  StageProfiler::stop_publishing();
+  StageProfiler::dump(std::cout);
+
+  delete agent;
+  delete environment;
+  return 0;
+}
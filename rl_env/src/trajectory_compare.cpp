@@ -0,0 +1,177 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cfloat>
+
+#include <getopt.h>
+#include <stdlib.h>
+
+// Compares trajectories logged by HectorQuad / HectorQuadSim in
+// quadrotor_trajectory.txt (x y z vx vy vz yaw_rate per line), eg. the
+// gazebo flights in apprenticeship/trajectory_circle* against a run of the
+// quadsim env with the same policy and trajectory. Only positions are used,
+// as the path and the time taken to fly it are what the agent is rewarded on.
+
+double sample_probability = 0.5; // THRESHOLD_PROBABILITY of the logged run
+double step_time = 0.1; // Seconds per logged step: phy_steps * 0.01
+
+struct Point {
+  double x, y, z;
+};
+
+struct Stats {
+  long samples;
+  double time; // Estimated from the number of samples
+  double radius_mean, radius_std, altitude_mean, speed_mean;
+};
+
+void display_help() {
+  std::cout << "\n trajectory_compare --reference file [--reference file ...]"
+            << " --trajectory file [--trajectory file ...] [options]\n";
+  std::cout << "\n Options:\n";
+  std::cout << "--reference file (Logged trajectory to compare against, eg. gazebo)\n";
+  std::cout << "--trajectory file (Logged trajectory to check, eg. quadsim)\n";
+  std::cout << "--probability p (Probability with which steps were logged. Default: 0.5)\n";
+  std::cout << "--step seconds (Time between two env steps. Default: 0.1)\n";
+  exit(-1);
+}
+
+std::vector<Point> load(const std::string &file_name) {
+  std::vector<Point> points;
+  std::ifstream f(file_name.c_str());
+  if (!f.good()) {
+    std::cerr << "Cannot read " << file_name << "\n";
+    exit(-1);
+  }
+
+  std::string line;
+  while (std::getline(f, line)) {
+    std::istringstream fields(line);
+    Point p;
+    if (fields >> p.x >> p.y >> p.z) {
+      points.push_back(p);
+    }
+  }
+  return points;
+}
+
+double distance(const Point &a, const Point &b) {
+  return sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) +
+              (a.z - b.z) * (a.z - b.z));
+}
+
+Stats get_stats(const std::vector<std::vector<Point> > &runs) {
+  Stats stats = {0, 0, 0, 0, 0, 0};
+  double radius_sq = 0, length = 0;
+  for (size_t r = 0; r < runs.size(); ++r) {
+    const std::vector<Point> &points = runs[r];
+    for (size_t i = 0; i < points.size(); ++i) {
+      double radius = sqrt(points[i].x * points[i].x + points[i].y * points[i].y);
+      stats.radius_mean += radius;
+      radius_sq += radius * radius;
+      stats.altitude_mean += points[i].z;
+      if (i > 0) length += distance(points[i - 1], points[i]);
+    }
+    stats.samples += points.size();
+  }
+  if (stats.samples == 0) return stats;
+
+  stats.time = stats.samples / sample_probability * step_time;
+  stats.radius_mean /= stats.samples;
+  stats.radius_std = sqrt(std::max(0.0, radius_sq / stats.samples -
+                                        stats.radius_mean * stats.radius_mean));
+  stats.altitude_mean /= stats.samples;
+  stats.speed_mean = length / stats.time;
+  stats.time /= runs.size(); // Per run
+  return stats;
+}
+
+// Mean and max distance from every point of `from` to the closest point of
+// any run in `to`
+void path_distance(const std::vector<std::vector<Point> > &from,
+                   const std::vector<std::vector<Point> > &to,
+                   double &mean, double &max) {
+  long n = 0;
+  mean = 0;
+  max = 0;
+  for (size_t r = 0; r < from.size(); ++r) {
+    for (size_t i = 0; i < from[r].size(); ++i) {
+      double closest = DBL_MAX;
+      for (size_t s = 0; s < to.size(); ++s) {
+        for (size_t j = 0; j < to[s].size(); ++j) {
+          closest = std::min(closest, distance(from[r][i], to[s][j]));
+        }
+      }
+      mean += closest;
+      max = std::max(max, closest);
+      n += 1;
+    }
+  }
+  if (n > 0) mean /= n;
+}
+
+void print_stats(const std::string &name, const Stats &stats) {
+  std::cout << name << ": " << stats.samples << " samples"
+            << ", time per run (s) " << stats.time
+            << ", radius " << stats.radius_mean << " +- " << stats.radius_std
+            << ", altitude " << stats.altitude_mean
+            << ", speed " << stats.speed_mean << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::vector<Point> > reference, trajectory;
+
+  char ch;
+  const char* optflags = "rtps";
+  int option_index = 0;
+  static struct option long_options[] = {
+    {"reference", 1, 0, 'r'},
+    {"trajectory", 1, 0, 't'},
+    {"probability", 1, 0, 'p'},
+    {"step", 1, 0, 's'},
+    {NULL, 0, 0, 0}
+  };
+
+  while(-1 != (ch = getopt_long_only(argc, argv, optflags, long_options, &option_index))) {
+    switch(ch) {
+    case 'r':
+      reference.push_back(load(optarg));
+      break;
+
+    case 't':
+      trajectory.push_back(load(optarg));
+      break;
+
+    case 'p':
+      sample_probability = std::atof(optarg);
+      break;
+
+    case 's':
+      step_time = std::atof(optarg);
+      break;
+
+    default:
+      display_help();
+      break;
+    }
+  }
+
+  if (reference.empty() || trajectory.empty() || sample_probability <= 0) {
+    display_help();
+  }
+
+  print_stats("Reference", get_stats(reference));
+  print_stats("Trajectory", get_stats(trajectory));
+
+  double mean, max;
+  path_distance(trajectory, reference, mean, max);
+  std::cout << "Distance from trajectory to reference path: mean " << mean
+            << " max " << max << "\n";
+  path_distance(reference, trajectory, mean, max);
+  std::cout << "Distance from reference to trajectory path: mean " << mean
+            << " max " << max << "\n";
+  return 0;
+}
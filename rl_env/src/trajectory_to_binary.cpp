@@ -0,0 +1,66 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <rl_env/trajectory/TrajectoryFile.h>
+
+#include <getopt.h>
+#include <stdlib.h>
+
+// Converts a recorded trajectory from the text format (x y z vx vy vz yaw
+// per line, eg. the "out" of the apprenticeship scripts) to the binary one
+// of TrajectoryFile, which WaypointsFile and PurePursuitFile map instead of
+// parsing.
+
+void display_help() {
+  std::cout << "\n trajectory_to_binary --input file --output file\n";
+  std::cout << "\n Options:\n";
+  std::cout << "--input file (Text trajectory)\n";
+  std::cout << "--output file (Binary trajectory to write, eg. out)\n";
+  exit(-1);
+}
+
+int main(int argc, char *argv[]) {
+  std::string input, output;
+
+  char ch;
+  const char* optflags = "io";
+  int option_index = 0;
+  static struct option long_options[] = {
+    {"input", 1, 0, 'i'},
+    {"output", 1, 0, 'o'},
+    {NULL, 0, 0, 0}
+  };
+
+  while(-1 != (ch = getopt_long_only(argc, argv, optflags, long_options, &option_index))) {
+    switch(ch) {
+    case 'i':
+      input = optarg;
+      break;
+
+    case 'o':
+      output = optarg;
+      break;
+
+    default:
+      display_help();
+      break;
+    }
+  }
+
+  if (input == "" || output == "") {
+    display_help();
+  }
+
+  std::vector<TrajectoryRecord> records;
+  if (!TrajectoryFile::read_text(input, records)) {
+    std::cerr << "Cannot read " << input << "\n";
+    return -1;
+  }
+  if (!TrajectoryFile::write(output, records)) {
+    std::cerr << "Cannot write " << output << "\n";
+    return -1;
+  }
+  std::cout << "Wrote " << records.size() << " samples to " << output << "\n";
+  return 0;
+}
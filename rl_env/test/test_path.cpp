@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <rl_env/trajectory/Path.h>
+
+namespace {
+
+geometry_msgs::Point make_point(double x, double y, double z) {
+  geometry_msgs::Point p;
+  p.x = x;
+  p.y = y;
+  p.z = z;
+  return p;
+}
+
+// Two laps of a circle of radius 5, 20 points per lap
+Path circle() {
+  std::vector<geometry_msgs::Point> points;
+  for (int i = 0; i < 40; ++i) {
+    double a = 2 * M_PI / 20 * i;
+    points.push_back(make_point(5 * sin(a), 5 * cos(a), 0));
+  }
+  return Path(points);
+}
+
+} // namespace
+
+TEST(Path, Lengths) {
+  std::vector<geometry_msgs::Point> points;
+  points.push_back(make_point(0, 0, 0));
+  points.push_back(make_point(3, 4, 0));
+  points.push_back(make_point(3, 4, 0)); // Of no length
+  points.push_back(make_point(3, 4, 2));
+  Path path(points);
+
+  ASSERT_EQ(4u, path.size());
+  ASSERT_EQ(3u, path.segments());
+  EXPECT_DOUBLE_EQ(7, path.length());
+  EXPECT_DOUBLE_EQ(5, path.arc_length(1));
+  EXPECT_DOUBLE_EQ(5, path.arc_length(2));
+  EXPECT_DOUBLE_EQ(0, path.segment_length(1));
+  EXPECT_TRUE(path.tangent(0).isApprox(Eigen::Vector3d(0.6, 0.8, 0)));
+  EXPECT_TRUE(path.tangent(1).isZero());
+  EXPECT_TRUE(path.tangent(2).isApprox(Eigen::Vector3d(0, 0, 1)));
+}
+
+TEST(Path, PointAtIsClampedToTheEnds) {
+  std::vector<geometry_msgs::Point> points;
+  points.push_back(make_point(0, 0, 0));
+  points.push_back(make_point(2, 0, 0));
+  points.push_back(make_point(2, 2, 0));
+  Path path(points);
+
+  EXPECT_TRUE(path.point_at(-1).isApprox(Eigen::Vector3d(0, 0, 0)));
+  EXPECT_TRUE(path.point_at(1).isApprox(Eigen::Vector3d(1, 0, 0)));
+  EXPECT_TRUE(path.point_at(3).isApprox(Eigen::Vector3d(2, 1, 0)));
+  EXPECT_TRUE(path.point_at(10).isApprox(Eigen::Vector3d(2, 2, 0)));
+}
+
+TEST(Path, HintedLookupsMatchBinarySearch) {
+  Path path = circle();
+  size_t hint = 0, point_hint = 0;
+  for (double s = -1; s < path.length() + 1; s += 0.37) {
+    size_t segment = path.segment_at(s);
+    hint = path.segment_at(s, hint);
+    ASSERT_EQ(segment, hint) << "at " << s;
+    ASSERT_TRUE(path.point_at(s).isApprox(path.point_at(s, point_hint)));
+    ASSERT_EQ(segment, point_hint);
+
+    // Going back falls back to the binary search
+    size_t back = path.segment_at(s / 2, hint);
+    ASSERT_EQ(path.segment_at(s / 2), back);
+  }
+}
+
+TEST(Path, PointsAreOnTheChords) {
+  Path path = circle();
+  // A chord of 1/20 of the circle sags 5 (1 - cos(pi / 20)) from it
+  double sag = 5 * (1 - cos(M_PI / 20));
+  for (double s = 0; s < path.length(); s += 0.1) {
+    double r = path.point_at(s).head<2>().norm();
+    ASSERT_LE(r, 5 + 1e-9);
+    ASSERT_GE(r, 5 - sag - 1e-9);
+  }
+}
+
+TEST(Path, Project) {
+  std::vector<geometry_msgs::Point> points;
+  points.push_back(make_point(0, 0, 0));
+  points.push_back(make_point(4, 0, 0));
+  Path path(points);
+
+  double along;
+  EXPECT_DOUBLE_EQ(1, path.project(Eigen::Vector3d(1, 1, 0), 0, along));
+  EXPECT_DOUBLE_EQ(1, along);
+  // Beyond the ends, to the end point
+  EXPECT_DOUBLE_EQ(2, path.project(Eigen::Vector3d(-1, 1, 0), 0, along));
+  EXPECT_DOUBLE_EQ(0, along);
+  EXPECT_DOUBLE_EQ(5, path.project(Eigen::Vector3d(6, 0, 1), 0, along));
+  EXPECT_DOUBLE_EQ(4, along);
+}
+
+TEST(Path, FirstBeyond) {
+  Path path = circle();
+  Eigen::Vector3d top(0, 5, 0); // Point 0
+  // Points 1 and 2 are 1.56 and 3.09 away
+  EXPECT_EQ(2u, path.first_beyond(top, 0, 2));
+  // Point 39 is the last one, and so is any point after it
+  EXPECT_EQ(39u, path.first_beyond(top, 39, 2));
+  EXPECT_EQ(39u, path.first_beyond(top, 100, 2));
+  EXPECT_EQ(0u, Path().first_beyond(top, 0, 2));
+}
+
+TEST(Path, Empty) {
+  Path path;
+  EXPECT_TRUE(path.empty());
+  EXPECT_EQ(0u, path.segments());
+  EXPECT_DOUBLE_EQ(0, path.length());
+  EXPECT_EQ(0u, path.segment_at(1));
+  EXPECT_TRUE(path.point_at(1).isZero());
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <rl_env/trajectory/SegmentBvh.h>
+
+namespace {
+
+// A noisy helix of n points, two laps per 2500 points
+std::vector<geometry_msgs::Point> helix(int n, std::mt19937 &rng) {
+  std::uniform_real_distribution<double> noise(0, 0.1);
+  std::vector<geometry_msgs::Point> points(n);
+  for (int i = 0; i < n; ++i) {
+    double a = 2 * M_PI / 1250 * i;
+    points[i].x = 5 * sin(a) + noise(rng);
+    points[i].y = 5 * cos(a);
+    points[i].z = 0.001 * i;
+  }
+  return points;
+}
+
+// The closest distance of segments first .. last to p, by a scan
+double scan(const Path &path, const Eigen::Vector3d &p, size_t first,
+            size_t last) {
+  double best = std::numeric_limits<double>::infinity();
+  for (size_t i = first; i <= last; ++i) {
+    double along;
+    best = std::min(best, path.project(p, i, along));
+  }
+  return best;
+}
+
+} // namespace
+
+TEST(SegmentBvh, NearestMatchesScan) {
+  std::mt19937 rng(1);
+  Path path(helix(2000, rng));
+  SegmentBvh bvh;
+  bvh.build(path);
+
+  std::uniform_real_distribution<double> xy(-10, 10), z(0, 6);
+  for (int k = 0; k < 500; ++k) {
+    Eigen::Vector3d p(xy(rng), xy(rng), z(rng));
+    SegmentBvh::Hit hit = bvh.nearest(p);
+    ASSERT_NEAR(scan(path, p, 0, path.segments() - 1), hit.distance_sq, 1e-5);
+
+    // The hit is consistent with its segment
+    double along;
+    EXPECT_NEAR(path.project(p, hit.segment, along), hit.distance_sq, 1e-5);
+    EXPECT_NEAR((p - hit.point).squaredNorm(), hit.distance_sq, 1e-5);
+  }
+}
+
+TEST(SegmentBvh, WindowMatchesScan) {
+  std::mt19937 rng(2);
+  Path path(helix(2000, rng));
+  SegmentBvh bvh;
+  bvh.build(path);
+
+  std::uniform_real_distribution<double> xy(-10, 10), z(0, 6);
+  std::uniform_int_distribution<size_t> start(0, path.segments() - 201);
+  for (int k = 0; k < 500; ++k) {
+    Eigen::Vector3d p(xy(rng), xy(rng), z(rng));
+    size_t first = start(rng), last = first + 200;
+    SegmentBvh::Hit hit = bvh.nearest(p, first, last, first + 100);
+    ASSERT_GE(hit.segment, first);
+    ASSERT_LE(hit.segment, last);
+    ASSERT_NEAR(scan(path, p, first, last), hit.distance_sq, 1e-5);
+  }
+}
+
+TEST(SegmentBvh, TiesGoToTheSegmentClosestToTheHint) {
+  // Three laps of the same circle: every point is as close to all of them
+  std::vector<geometry_msgs::Point> points(301);
+  for (size_t i = 0; i < points.size(); ++i) {
+    double a = 2 * M_PI / 100 * i;
+    points[i].x = 5 * cos(a);
+    points[i].y = 5 * sin(a);
+  }
+  Path path(points);
+  SegmentBvh bvh;
+  bvh.build(path);
+
+  Eigen::Vector3d p(6, 0.1, 0); // Closest to segment 0, 100 and 200
+  EXPECT_EQ(0u, bvh.nearest(p, 0, path.segments() - 1, 10).segment);
+  EXPECT_EQ(100u, bvh.nearest(p, 0, path.segments() - 1, 110).segment);
+  EXPECT_EQ(200u, bvh.nearest(p, 0, path.segments() - 1, 250).segment);
+}
+
+TEST(SegmentBvh, EmptyPath) {
+  Path path;
+  SegmentBvh bvh;
+  bvh.build(path);
+  EXPECT_TRUE(bvh.empty());
+  EXPECT_TRUE(std::isinf(bvh.nearest(Eigen::Vector3d(1, 2, 3)).distance_sq));
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fstream>
+
+#include <unistd.h>
+
+#include <rl_env/trajectory/TrajectoryFile.h>
+
+// Each test writes its own file in a directory of the whole suite
+class TrajectoryFileTest : public testing::Test {
+protected:
+  static std::string directory;
+  std::string file_name;
+
+  static void SetUpTestCase() {
+    char name[] = "/tmp/trajectory_file_XXXXXX";
+    directory = mkdtemp(name);
+  }
+
+  static void TearDownTestCase() {
+    std::string command = "rm -rf " + directory;
+    system(command.c_str());
+  }
+
+  virtual void SetUp() {
+    file_name = directory + "/" +
+                testing::UnitTest::GetInstance()->current_test_info()->name();
+  }
+};
+
+std::string TrajectoryFileTest::directory;
+
+// n samples along x, turning at 0.5 rad per sample
+static std::vector<TrajectoryRecord> records(int n) {
+  std::vector<TrajectoryRecord> r(n);
+  for (int i = 0; i < n; ++i) {
+    TrajectoryRecord record = {(float)i, 2, 3, 4, 5, 6, 0.5f * i};
+    r[i] = record;
+  }
+  return r;
+}
+
+TEST_F(TrajectoryFileTest, BinaryIsMapped) {
+  std::vector<TrajectoryRecord> written = records(100);
+  ASSERT_TRUE(TrajectoryFile::write(file_name, written));
+
+  TrajectoryFile file(file_name);
+  ASSERT_TRUE(file.good());
+  EXPECT_TRUE(file.mapped());
+  ASSERT_EQ(written.size(), file.size());
+  for (size_t i = 0; i < written.size(); ++i) {
+    EXPECT_EQ(written[i].x, file[i].x);
+    EXPECT_EQ(written[i].vz, file[i].vz);
+    EXPECT_EQ(written[i].yaw, file[i].yaw);
+  }
+}
+
+TEST_F(TrajectoryFileTest, EmptyBinary) {
+  ASSERT_TRUE(TrajectoryFile::write(file_name, std::vector<TrajectoryRecord>()));
+  TrajectoryFile file(file_name);
+  EXPECT_TRUE(file.mapped());
+  EXPECT_EQ(0u, file.size());
+}
+
+TEST_F(TrajectoryFileTest, TextIsParsed) {
+  {
+    std::ofstream text(file_name.c_str());
+    text << "1 2 3 4 5 6 0.1\n"
+         << "not a sample\n"
+         << "2 2 3 4 5\n" // Too short
+         << "3 2 3 4 5 6 0.3\n";
+  }
+
+  TrajectoryFile file(file_name);
+  ASSERT_TRUE(file.good());
+  EXPECT_FALSE(file.mapped());
+  ASSERT_EQ(2u, file.size());
+  EXPECT_FLOAT_EQ(1, file[0].x);
+  EXPECT_FLOAT_EQ(0.1f, file[0].yaw);
+  EXPECT_FLOAT_EQ(3, file[1].x);
+  EXPECT_FLOAT_EQ(0.3f, file[1].yaw);
+}
+
+TEST_F(TrajectoryFileTest, CutShortBinaryIsNotRead) {
+  ASSERT_TRUE(TrajectoryFile::write(file_name, records(10)));
+  ASSERT_EQ(0, truncate(file_name.c_str(), sizeof(TrajectoryFile::Header) +
+                                           5 * sizeof(TrajectoryRecord) + 3));
+
+  // Nor parsed as a text file
+  TrajectoryFile file(file_name);
+  EXPECT_FALSE(file.good());
+  EXPECT_EQ(0u, file.size());
+}
+
+TEST_F(TrajectoryFileTest, OtherVersionIsNotRead) {
+  ASSERT_TRUE(TrajectoryFile::write(file_name, records(10)));
+  {
+    std::fstream binary(file_name.c_str(),
+                        std::ios::in | std::ios::out | std::ios::binary);
+    uint32_t version = TRAJECTORY_FILE_VERSION + 1;
+    binary.seekp(sizeof(uint32_t));
+    binary.write(reinterpret_cast<const char*>(&version), sizeof(version));
+  }
+
+  TrajectoryFile file(file_name);
+  EXPECT_FALSE(file.good());
+}
+
+TEST_F(TrajectoryFileTest, MissingFile) {
+  TrajectoryFile file(file_name);
+  EXPECT_FALSE(file.good());
+  EXPECT_EQ(0u, file.size());
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}